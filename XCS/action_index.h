@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+namespace XCS
+{
+
+    // Dense numbering of the available actions (0, 1, ..., size() - 1)
+    //   Built once from the set of available actions, so per-action data (prediction
+    //   array, covered actions) can be kept in plain arrays indexed by idx(action).
+    //   Lookups scan the action list when there are few actions and use a hash map
+    //   otherwise.
+    template <typename Action>
+    class ActionIndex
+    {
+    private:
+        static constexpr std::size_t maxLinearSearchSize = 16;
+
+        std::vector<Action> m_actions;
+        std::unordered_map<Action, std::size_t> m_idxs;
+
+    public:
+        // Constructor
+        explicit ActionIndex(const std::unordered_set<Action> & availableActions) :
+            m_actions(availableActions.begin(), availableActions.end())
+        {
+            if (m_actions.size() > maxLinearSearchSize)
+            {
+                for (std::size_t i = 0; i < m_actions.size(); ++i)
+                {
+                    m_idxs.emplace(m_actions[i], i);
+                }
+            }
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_actions.size();
+        }
+
+        Action action(std::size_t idx) const
+        {
+            assert(idx < m_actions.size());
+            return m_actions[idx];
+        }
+
+        const std::vector<Action> & actions() const noexcept
+        {
+            return m_actions;
+        }
+
+        // Returns the index of an available action
+        std::size_t idx(const Action & action) const
+        {
+            if (m_idxs.empty())
+            {
+                auto it = std::find(m_actions.begin(), m_actions.end(), action);
+                assert(it != m_actions.end());
+                return it - m_actions.begin();
+            }
+
+            assert(m_idxs.count(action) != 0);
+            return m_idxs.find(action)->second;
+        }
+    };
+
+}
@@ -2,9 +2,12 @@
 
 #include <vector>
 #include <unordered_set>
-#include <unordered_map>
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
+
+#include "profiler.h"
 
 namespace XCS
 {
@@ -17,34 +20,117 @@ namespace XCS
         using ClassifierPtrSet::m_set;
         using ClassifierPtrSet::m_constants;
         using ClassifierPtrSet::m_availableActions;
+        using ClassifierPtrSet::eraseAt;
 
         GA m_ga;
 
-        // UPDATE FITNESS
-        virtual void updateFitness()
+        // Parameters of the classifiers in the set as parallel arrays (gathered by
+        // update() and scattered back after the update; reused to avoid allocation)
+        //   action_set_update_benchmark.cpp compares this with updating the classifiers
+        //   in place.
+        struct ParameterArrays
         {
-            double accuracySum = 0.0;
+            std::vector<Classifier *> classifiers;
+            std::vector<double> prediction;
+            std::vector<double> predictionError;
+            std::vector<double> fitness;
+            std::vector<double> experience;
+            std::vector<double> actionSetSize;
+            std::vector<double> numerosity;
+            std::vector<double> accuracy;
 
-            // Accuracy vector
-            std::unordered_map<const ClassifierPtr *, double> kappa(m_set.size());
+            void resize(std::size_t size)
+            {
+                classifiers.resize(size);
+                for (auto && parameter : { &prediction, &predictionError, &fitness, &experience, &actionSetSize, &numerosity, &accuracy })
+                {
+                    parameter->resize(size);
+                }
+            }
+        };
+
+        ParameterArrays m_parameters;
+
+        void gatherParameters()
+        {
+            m_parameters.resize(m_set.size());
 
+            std::size_t i = 0;
             for (auto && cl : m_set)
             {
-                if (cl->predictionError < m_constants.predictionErrorThreshold)
+                m_parameters.classifiers[i] = cl.get();
+                m_parameters.prediction[i] = cl->prediction;
+                m_parameters.predictionError[i] = cl->predictionError;
+                m_parameters.fitness[i] = cl->fitness;
+                m_parameters.experience[i] = cl->experience;
+                m_parameters.actionSetSize[i] = cl->actionSetSize;
+                m_parameters.numerosity[i] = static_cast<double>(cl->numerosity);
+                ++i;
+            }
+        }
+
+        void scatterParameters()
+        {
+            for (std::size_t i = 0; i < m_parameters.classifiers.size(); ++i)
+            {
+                Classifier * cl = m_parameters.classifiers[i];
+                cl->prediction = m_parameters.prediction[i];
+                cl->predictionError = m_parameters.predictionError[i];
+                cl->fitness = m_parameters.fitness[i];
+                cl->experience = m_parameters.experience[i];
+                cl->actionSetSize = m_parameters.actionSetSize[i];
+            }
+        }
+
+        // UPDATE FITNESS (on the gathered parameters)
+        virtual void updateFitness()
+        {
+            const std::size_t size = m_parameters.classifiers.size();
+            const double * predictionError = m_parameters.predictionError.data();
+            const double * numerosity = m_parameters.numerosity.data();
+            double * fitness = m_parameters.fitness.data();
+            double * kappa = m_parameters.accuracy.data();
+
+            // Accuracy vector
+            //   kappa = alpha * (e_0 / epsilon)^nu. For an integral nu below 16 (5 by
+            //   default), the power is taken by squaring in four steps so that the loop
+            //   vectorizes; pow() keeps it scalar otherwise.
+            const double threshold = m_constants.predictionErrorThreshold;
+            const double alpha = m_constants.alpha;
+            const double nu = m_constants.nu;
+            if (nu >= 0.0 && nu < 16.0 && nu == std::floor(nu))
+            {
+                const unsigned int exponent = static_cast<unsigned int>(nu);
+                for (std::size_t i = 0; i < size; ++i)
                 {
-                    kappa[&cl] = 1.0;
+                    double base = threshold / predictionError[i];
+                    double power = 1.0;
+                    for (unsigned int bit = 0; bit < 4; ++bit)
+                    {
+                        power *= ((exponent >> bit) & 1) ? base : 1.0;
+                        base *= base;
+                    }
+                    kappa[i] = (predictionError[i] < threshold) ? 1.0 : alpha * power;
                 }
-                else
+            }
+            else
+            {
+                for (std::size_t i = 0; i < size; ++i)
                 {
-                    kappa[&cl] = m_constants.alpha * pow(cl->predictionError / m_constants.predictionErrorThreshold, -m_constants.nu);
+                    kappa[i] = (predictionError[i] < threshold) ? 1.0 : alpha * std::pow(predictionError[i] / threshold, -nu);
                 }
+            }
 
-                accuracySum += kappa[&cl] * cl->numerosity;
+            double accuracySum = 0.0;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                accuracySum += kappa[i] * numerosity[i];
             }
 
-            for (auto && cl : m_set)
+            const double learningRate = m_constants.learningRate;
+            for (std::size_t i = 0; i < size; ++i)
             {
-                cl->fitness += m_constants.learningRate * (kappa[&cl] * cl->numerosity / accuracySum - cl->fitness);
+                fitness[i] += learningRate * (kappa[i] * numerosity[i] / accuracySum - fitness[i]);
             }
         }
 
@@ -70,21 +156,22 @@ namespace XCS
 
             if (cl.get() != nullptr)
             {
-                std::vector<const ClassifierPtr *> removedClassifiers;
-                for (auto && c : m_set)
+                for (std::size_t i = 0; i < m_set.size(); )
                 {
-                    if (cl->isMoreGeneral(*c))
+                    if (cl->isMoreGeneral(*m_set[i]))
+                    {
+                        XCS_PROFILE_COUNT(Subsumption);
+                        cl->numerosity += m_set[i]->numerosity;
+                        population.erase(m_set[i]);
+                        eraseAt(i);
+                    }
+                    else
                     {
-                        cl->numerosity += c->numerosity;
-                        removedClassifiers.push_back(&c);
+                        ++i;
                     }
                 }
 
-                for (auto && removedClassifier : removedClassifiers)
-                {
-                    population.erase(*removedClassifier);
-                    m_set.erase(*removedClassifier);
-                }
+                population.updateDeletionVote(cl);
             }
         }
 
@@ -115,7 +202,7 @@ namespace XCS
             {
                 if (cl->action == action)
                 {
-                    m_set.insert(cl);
+                    m_set.push_back(cl);
                 }
             }
         }
@@ -125,9 +212,18 @@ namespace XCS
             dest.m_set = m_set; // don't copy m_ga since it contains const parameters
         }
 
+        // Moves the classifiers to dest by swapping buffers (leaves this set with the
+        // previous contents of dest)
+        virtual void moveTo(ActionSet<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA> & dest)
+        {
+            m_set.swap(dest.m_set);
+        }
+
         // RUN GA (refer to GA::run() for the latter part)
         virtual void runGA(const std::vector<T> & situation, Population & population, uint64_t timeStamp)
         {
+            XCS_PROFILE_PHASE(GA);
+
             uint64_t timeStampNumerositySum = 0;
             uint64_t numerositySum = 0;
 
@@ -146,43 +242,56 @@ namespace XCS
                     cl->timeStamp = timeStamp;
                 }
 
+                XCS_PROFILE_COUNT(GA);
                 m_ga.run(*this, situation, population);
             }
         }
 
         // UPDATE SET
+        //   The parameters are gathered into parallel arrays so that the updates below
+        //   run as branch-free loops the compiler can vectorize. The MAM technique's
+        //   "exp < 1 / beta ? 1 / exp : beta" is written as max(beta, 1 / exp).
         virtual void update(double p, Population & population)
         {
+            XCS_PROFILE_PHASE(ActionSetUpdate);
+
+            gatherParameters();
+
+            const std::size_t size = m_parameters.classifiers.size();
+            double * prediction = m_parameters.prediction.data();
+            double * predictionError = m_parameters.predictionError.data();
+            double * experience = m_parameters.experience.data();
+            double * actionSetSize = m_parameters.actionSetSize.data();
+            const double * numerosity = m_parameters.numerosity.data();
+
             // Calculate numerosity sum used for updating action set size estimate
-            uint64_t numerositySum = 0;
-            for (auto && cl : m_set)
+            double numerositySum = 0.0;
+            for (std::size_t i = 0; i < size; ++i)
             {
-                numerositySum += cl->numerosity;
+                numerositySum += numerosity[i];
             }
 
-            for (auto && cl : m_set)
+            // Update prediction, prediction error, and action set size estimate
+            const double learningRate = m_constants.learningRate;
+            for (std::size_t i = 0; i < size; ++i)
             {
-                ++cl->experience;
+                experience[i] += 1.0;
 
-                // Update prediction, prediction error, and action set size estimate
-                if (cl->experience < 1.0 / m_constants.learningRate)
-                {
-                    cl->prediction += (p - cl->prediction) / cl->experience;
-                    cl->predictionError += (fabs(p - cl->prediction) - cl->predictionError) / cl->experience;
-                    cl->actionSetSize += (numerositySum - cl->actionSetSize) / cl->experience;
-                }
-                else
-                {
-                    cl->prediction += m_constants.learningRate * (p - cl->prediction);
-                    cl->predictionError += m_constants.learningRate * (fabs(p - cl->prediction) - cl->predictionError);
-                    cl->actionSetSize += m_constants.learningRate * (numerositySum - cl->actionSetSize);
-                }
+                double rate = std::max(learningRate, 1.0 / experience[i]);
+                prediction[i] += rate * (p - prediction[i]);
+                predictionError[i] += rate * (std::fabs(p - prediction[i]) - predictionError[i]);
+                actionSetSize[i] += rate * (numerositySum - actionSetSize[i]);
             }
 
             updateFitness();
 
+            scatterParameters();
+
+            population.updateDeletionVotes(m_parameters.classifiers);
+
             if (m_constants.doActionSetSubsumption)
             {
+                XCS_PROFILE_PHASE(Subsumption);
                 doSubsumption(population);
             }
         }
@@ -0,0 +1,292 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstddef>
+#include <utility>
+
+#include "packed_experiment.h"
+
+using namespace XCS;
+
+using BenchmarkCondition = PackedCondition;
+using BenchmarkConditionActionPair = PackedConditionActionPair<bool, bool, Symbol<bool>, BenchmarkCondition>;
+using BenchmarkClassifier = Classifier<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkConditionActionPair, Constants>;
+using BenchmarkClassifierPtrSet = ClassifierPtrSet<bool, BenchmarkClassifier, Constants>;
+using BenchmarkPopulation = Population<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, Constants, BenchmarkClassifierPtrSet>;
+using BenchmarkMatchSet = MatchSet<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, Constants, BenchmarkClassifierPtrSet, BenchmarkPopulation>;
+using BenchmarkGA = PackedGA<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, BenchmarkPopulation, Constants, BenchmarkClassifierPtrSet>;
+using BenchmarkActionSetBase = ActionSet<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, Constants, BenchmarkClassifierPtrSet, BenchmarkPopulation, BenchmarkMatchSet, BenchmarkGA>;
+
+// Action set that can also be updated the way it was before the parameter arrays:
+// in place on the classifiers, with pow() and one deletion vote update per classifier
+class BenchmarkActionSet : public BenchmarkActionSetBase
+{
+private:
+    std::vector<double> m_kappa;
+
+public:
+    // Constructor
+    explicit BenchmarkActionSet(const Constants & constants) : BenchmarkActionSetBase(constants, { false, true }) {}
+
+    void assign(const std::vector<std::shared_ptr<BenchmarkClassifier>> & classifiers)
+    {
+        m_set = classifiers;
+    }
+
+    void updateInPlace(double p, BenchmarkPopulation & population)
+    {
+        double numerositySum = 0.0;
+        for (auto && cl : m_set)
+        {
+            numerositySum += cl->numerosity;
+        }
+
+        for (auto && cl : m_set)
+        {
+            cl->experience += 1.0;
+
+            double rate = std::max(m_constants.learningRate, 1.0 / cl->experience);
+            cl->prediction += rate * (p - cl->prediction);
+            cl->predictionError += rate * (std::fabs(p - cl->prediction) - cl->predictionError);
+            cl->actionSetSize += rate * (numerositySum - cl->actionSetSize);
+        }
+
+        m_kappa.resize(m_set.size());
+        double accuracySum = 0.0;
+        for (std::size_t i = 0; i < m_set.size(); ++i)
+        {
+            auto && cl = m_set[i];
+            if (cl->predictionError < m_constants.predictionErrorThreshold)
+            {
+                m_kappa[i] = 1.0;
+            }
+            else
+            {
+                m_kappa[i] = m_constants.alpha * std::pow(cl->predictionError / m_constants.predictionErrorThreshold, -m_constants.nu);
+            }
+            accuracySum += m_kappa[i] * cl->numerosity;
+        }
+
+        for (std::size_t i = 0; i < m_set.size(); ++i)
+        {
+            auto && cl = m_set[i];
+            cl->fitness += m_constants.learningRate * (m_kappa[i] * cl->numerosity / accuracySum - cl->fitness);
+        }
+
+        for (auto && cl : m_set)
+        {
+            population.updateDeletionVote(cl);
+        }
+    }
+};
+
+// Fills a population with classifiers with random parameters and returns them
+static std::vector<std::shared_ptr<BenchmarkClassifier>> fillPopulation(BenchmarkPopulation & population, std::size_t classifierCount, std::size_t length, const Constants & constants)
+{
+    std::vector<std::shared_ptr<BenchmarkClassifier>> classifiers;
+    for (std::size_t i = 0; i < classifierCount; ++i)
+    {
+        std::vector<bool> situation;
+        for (std::size_t j = 0; j < length; ++j)
+        {
+            situation.push_back(Random::nextInt(0, 1) == 1);
+        }
+
+        auto cl = population.makeClassifier(BenchmarkCondition(situation), Random::nextInt(0, 1) == 1, 0, constants);
+        cl->condition.randomGeneralize(constants.generalizeProbability);
+        cl->prediction = Random::nextDouble(0.0, 1000.0);
+        cl->predictionError = Random::nextDouble(0.0, 100.0);
+        cl->fitness = Random::nextDouble(0.01, 1.0);
+        cl->experience = static_cast<double>(Random::nextInt(0, 100));
+        cl->actionSetSize = Random::nextDouble(1.0, 50.0);
+        cl->numerosity = Random::nextInt(1, 5);
+        population.insert(cl);
+        classifiers.push_back(cl);
+    }
+    return classifiers;
+}
+
+// Random action sets of the given size drawn from the classifiers (without repetition,
+// as in a real action set)
+static std::vector<std::vector<std::size_t>> randomActionSets(std::size_t setCount, std::size_t setSize, std::size_t classifierCount)
+{
+    std::vector<std::size_t> idxs(classifierCount);
+    for (std::size_t i = 0; i < classifierCount; ++i)
+    {
+        idxs[i] = i;
+    }
+
+    std::vector<std::vector<std::size_t>> sets(setCount);
+    for (auto && set : sets)
+    {
+        // Partial Fisher-Yates shuffle
+        for (std::size_t i = 0; i < setSize; ++i)
+        {
+            std::swap(idxs[i], idxs[Random::nextInt<std::size_t>(i, classifierCount - 1)]);
+            set.push_back(idxs[i]);
+        }
+    }
+    return sets;
+}
+
+// Two identical populations of classifiers with random parameters, one updated in
+// place and one through ActionSet::update()
+class UpdateComparison
+{
+private:
+    const std::size_t m_classifierCount;
+    BenchmarkPopulation m_inPlacePopulation;
+    BenchmarkPopulation m_arrayPopulation;
+    std::vector<std::shared_ptr<BenchmarkClassifier>> m_inPlaceClassifiers;
+    std::vector<std::shared_ptr<BenchmarkClassifier>> m_arrayClassifiers;
+    BenchmarkActionSet m_actionSet;
+
+    // Runs each action set in turn updateCount times in total and returns the average
+    // time per update in nanoseconds
+    template <class Update>
+    double run(const std::vector<std::shared_ptr<BenchmarkClassifier>> & classifiers, const std::vector<std::vector<std::size_t>> & sets, std::size_t updateCount, Update update)
+    {
+        std::vector<std::vector<std::shared_ptr<BenchmarkClassifier>>> members;
+        for (auto && set : sets)
+        {
+            members.emplace_back();
+            for (auto && idx : set)
+            {
+                members.back().push_back(classifiers[idx]);
+            }
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < updateCount; ++i)
+        {
+            m_actionSet.assign(members[i % members.size()]);
+            update((i % 2 == 0) ? 1000.0 : 0.0);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - begin).count() / updateCount;
+    }
+
+public:
+    // Constructor
+    UpdateComparison(const Constants & constants, std::size_t classifierCount, std::size_t length) :
+        m_classifierCount(classifierCount),
+        m_inPlacePopulation(constants, { false, true }),
+        m_arrayPopulation(constants, { false, true }),
+        m_actionSet(constants)
+    {
+        RandomEngine fillEngine = Random::engine();
+        {
+            Random::Scope fillScope(fillEngine);
+            m_inPlaceClassifiers = fillPopulation(m_inPlacePopulation, classifierCount, length, constants);
+        }
+        m_arrayClassifiers = fillPopulation(m_arrayPopulation, classifierCount, length, constants);
+    }
+
+    std::size_t classifierCount() const noexcept
+    {
+        return m_classifierCount;
+    }
+
+    double runInPlace(const std::vector<std::vector<std::size_t>> & sets, std::size_t updateCount)
+    {
+        return run(m_inPlaceClassifiers, sets, updateCount, [&](double p) {
+            m_actionSet.updateInPlace(p, m_inPlacePopulation);
+        });
+    }
+
+    double runArrays(const std::vector<std::vector<std::size_t>> & sets, std::size_t updateCount)
+    {
+        return run(m_arrayClassifiers, sets, updateCount, [&](double p) {
+            m_actionSet.update(p, m_arrayPopulation);
+        });
+    }
+
+    // Returns true if both populations have the same parameters up to rounding
+    bool agrees() const
+    {
+        auto isClose = [](double x, double y) {
+            return std::fabs(x - y) <= 1e-9 * std::max(1.0, std::fabs(y));
+        };
+
+        for (std::size_t i = 0; i < m_classifierCount; ++i)
+        {
+            auto && a = *m_arrayClassifiers[i];
+            auto && b = *m_inPlaceClassifiers[i];
+            if (a.experience != b.experience || !isClose(a.prediction, b.prediction) || !isClose(a.predictionError, b.predictionError)
+                || !isClose(a.actionSetSize, b.actionSetSize) || !isClose(a.fitness, b.fitness))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Usage: xcs_action_set_update_benchmark [classifier count] [update count]
+//   Compares ActionSet::update() on gathered parameter arrays with updating the
+//   classifiers in place (pow() and one deletion vote update per classifier), for
+//   several action set sizes, on two identical populations of classifiers with random
+//   parameters. Then checks the power by squaring of update() against pow() for
+//   every integral nu below 16. Exits with 1 if the two updates give different
+//   parameters.
+int main(int argc, char * argv[])
+{
+    std::size_t classifierCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 5000;
+    std::size_t updateCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 200000;
+
+    Constants constants;
+    constants.doActionSetSubsumption = false;
+
+    RandomEngine engine(1);
+    Random::Scope randomScope(engine);
+
+    bool isPassed = true;
+
+    UpdateComparison comparison(constants, classifierCount, 37);
+
+    std::cout << "size,in-place ns/update,arrays ns/update,speedup" << std::endl;
+    for (std::size_t setSize : { 10, 30, 100, 300, 1000 })
+    {
+        if (setSize > classifierCount)
+        {
+            break;
+        }
+
+        auto sets = randomActionSets(256, setSize, classifierCount);
+        std::size_t setUpdateCount = std::max<std::size_t>(updateCount / setSize, 1);
+
+        double inPlaceTime = comparison.runInPlace(sets, setUpdateCount);
+        double arrayTime = comparison.runArrays(sets, setUpdateCount);
+
+        std::cout << setSize << "," << inPlaceTime << "," << arrayTime << "," << inPlaceTime / arrayTime << std::endl;
+    }
+
+    if (!comparison.agrees())
+    {
+        std::cerr << "Parameters differ between the two updates" << std::endl;
+        isPassed = false;
+    }
+
+    // The fast path of the accuracy (integral nu below 16) against pow()
+    for (unsigned int nu = 0; nu < 16; ++nu)
+    {
+        Constants nuConstants = constants;
+        nuConstants.nu = nu;
+
+        UpdateComparison nuComparison(nuConstants, 1000, 37);
+        auto sets = randomActionSets(64, 30, nuComparison.classifierCount());
+        nuComparison.runInPlace(sets, 2000);
+        nuComparison.runArrays(sets, 2000);
+        if (!nuComparison.agrees())
+        {
+            std::cerr << "Parameters differ between the two updates for nu = " << nu << std::endl;
+            isPassed = false;
+        }
+    }
+
+    return isPassed ? 0 : 1;
+}
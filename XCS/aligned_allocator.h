@@ -0,0 +1,80 @@
+#pragma once
+
+#include <new>
+#include <cstdlib>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace XCS
+{
+
+    // Allocator returning memory aligned to the given boundary (for SIMD loads)
+    template <typename T, std::size_t Alignment>
+    class AlignedAllocator
+    {
+    public:
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = AlignedAllocator<U, Alignment>;
+        };
+
+        // Constructor
+        AlignedAllocator() noexcept = default;
+
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U, Alignment> &) noexcept {}
+
+        T * allocate(std::size_t n)
+        {
+            if (n == 0)
+            {
+                return nullptr;
+            }
+
+            std::size_t bytes = (n * sizeof(T) + Alignment - 1) / Alignment * Alignment;
+#if defined(_MSC_VER)
+            void * ptr = _aligned_malloc(bytes, Alignment);
+#else
+            void * ptr = nullptr;
+            if (posix_memalign(&ptr, Alignment, bytes) != 0)
+            {
+                ptr = nullptr;
+            }
+#endif
+            if (ptr == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+
+            return static_cast<T *>(ptr);
+        }
+
+        void deallocate(T * ptr, std::size_t) noexcept
+        {
+#if defined(_MSC_VER)
+            _aligned_free(ptr);
+#else
+            free(ptr);
+#endif
+        }
+
+        template <typename U>
+        friend bool operator== (const AlignedAllocator &, const AlignedAllocator<U, Alignment> &) noexcept
+        {
+            return true;
+        }
+
+        template <typename U>
+        friend bool operator!= (const AlignedAllocator &, const AlignedAllocator<U, Alignment> &) noexcept
+        {
+            return false;
+        }
+    };
+
+}
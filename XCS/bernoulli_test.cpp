@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+#include "random.h"
+
+using namespace XCS;
+
+// Per-position success counts and the histogram of successes per trial
+struct BernoulliSample
+{
+    std::vector<uint64_t> positionCounts;
+    std::vector<uint64_t> successCountHistogram;
+    bool isOrdered;
+
+    BernoulliSample(std::size_t n) : positionCounts(n, 0), successCountHistogram(n + 1, 0), isOrdered(true) {}
+};
+
+// Samples with Random::forEachBernoulliSuccess()
+static BernoulliSample sampleGeometric(std::size_t n, double p, std::size_t trialCount, uint64_t seed)
+{
+    RandomEngine engine(seed);
+    Random::Scope scope(engine);
+
+    BernoulliSample sample(n);
+    for (std::size_t t = 0; t < trialCount; ++t)
+    {
+        std::size_t successCount = 0;
+        std::size_t prevIdx = 0;
+        Random::forEachBernoulliSuccess(n, p, [&](std::size_t i) {
+            if (i >= n || (successCount > 0 && i <= prevIdx))
+            {
+                sample.isOrdered = false;
+                return;
+            }
+            ++sample.positionCounts[i];
+            ++successCount;
+            prevIdx = i;
+        });
+        ++sample.successCountHistogram[successCount];
+    }
+    return sample;
+}
+
+// Samples per allele by testing nextDouble() < p for every position (the reference)
+static BernoulliSample samplePerAllele(std::size_t n, double p, std::size_t trialCount, uint64_t seed)
+{
+    RandomEngine engine(seed);
+    Random::Scope scope(engine);
+
+    BernoulliSample sample(n);
+    for (std::size_t t = 0; t < trialCount; ++t)
+    {
+        std::size_t successCount = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (Random::nextDouble() < p)
+            {
+                ++sample.positionCounts[i];
+                ++successCount;
+            }
+        }
+        ++sample.successCountHistogram[successCount];
+    }
+    return sample;
+}
+
+// Chi-square statistic and degrees of freedom
+struct ChiSquare
+{
+    double statistic;
+    std::size_t degreesOfFreedom;
+
+    // The standard normal deviate of the statistic (Wilson-Hilferty approximation)
+    double z() const
+    {
+        double k = static_cast<double>(degreesOfFreedom);
+        return (std::cbrt(statistic / k) - (1.0 - 2.0 / (9.0 * k))) / std::sqrt(2.0 / (9.0 * k));
+    }
+};
+
+// Two-sample test of the success frequency at each position (one degree of freedom
+// per position with successes in either sample)
+static ChiSquare comparePositions(const BernoulliSample & a, const BernoulliSample & b, std::size_t trialCount)
+{
+    ChiSquare result = { 0.0, 0 };
+    for (std::size_t i = 0; i < a.positionCounts.size(); ++i)
+    {
+        double pooled = static_cast<double>(a.positionCounts[i] + b.positionCounts[i]) / (2.0 * trialCount);
+        if (pooled <= 0.0 || pooled >= 1.0)
+        {
+            continue;
+        }
+
+        double difference = static_cast<double>(a.positionCounts[i]) - static_cast<double>(b.positionCounts[i]);
+        result.statistic += difference * difference / (2.0 * trialCount * pooled * (1.0 - pooled));
+        ++result.degreesOfFreedom;
+    }
+    return result;
+}
+
+// Two-sample (2 x K contingency) test of the success-count histograms
+//   Adjacent counts are merged until each bin expects at least 10 trials per sample.
+static ChiSquare compareHistograms(const BernoulliSample & a, const BernoulliSample & b)
+{
+    const double minBinCount = 20.0;
+
+    std::vector<std::pair<double, double>> bins;
+    std::pair<double, double> bin(0.0, 0.0);
+    for (std::size_t k = 0; k < a.successCountHistogram.size(); ++k)
+    {
+        bin.first += a.successCountHistogram[k];
+        bin.second += b.successCountHistogram[k];
+        if (bin.first + bin.second >= minBinCount)
+        {
+            bins.push_back(bin);
+            bin = std::make_pair(0.0, 0.0);
+        }
+    }
+    if (!bins.empty())
+    {
+        bins.back().first += bin.first;
+        bins.back().second += bin.second;
+    }
+
+    ChiSquare result = { 0.0, (bins.size() > 1) ? bins.size() - 1 : 0 };
+    for (auto && counts : bins)
+    {
+        // Equal trial counts, so each sample expects half of the pooled count
+        double expected = (counts.first + counts.second) / 2.0;
+        result.statistic += (counts.first - expected) * (counts.first - expected) / expected;
+        result.statistic += (counts.second - expected) * (counts.second - expected) / expected;
+    }
+    return result;
+}
+
+// Usage: xcs_bernoulli_test
+//   Checks that Random::forEachBernoulliSuccess() selects positions with the same
+//   distribution as testing every position independently, and exits with 1 if a
+//   chi-square statistic is implausibly large (z > 4.5, about 3e-6 per test). The
+//   seeds are fixed, so the result is reproducible.
+int main()
+{
+    const std::size_t trialCount = 100000;
+    const double maxZ = 4.5;
+
+    struct Case
+    {
+        std::size_t n;
+        double p;
+    };
+    const Case cases[] = {
+        { 6, 0.04 },
+        { 16, 0.04 },
+        { 37, 0.33 },
+        { 64, 0.5 },
+        { 135, 0.01 },
+        { 20, 0.95 },
+        { 1000, 0.002 },
+    };
+
+    bool isPassed = true;
+
+    std::cout << "n,p,position chi2,dof,z,histogram chi2,dof,z" << std::endl;
+    uint64_t seed = 1;
+    for (auto && c : cases)
+    {
+        BernoulliSample geometric = sampleGeometric(c.n, c.p, trialCount, seed++);
+        BernoulliSample perAllele = samplePerAllele(c.n, c.p, trialCount, seed++);
+
+        ChiSquare positions = comparePositions(geometric, perAllele, trialCount);
+        ChiSquare histograms = compareHistograms(geometric, perAllele);
+
+        std::cout << c.n << "," << c.p << ","
+            << std::fixed << std::setprecision(2)
+            << positions.statistic << "," << positions.degreesOfFreedom << "," << positions.z() << ","
+            << histograms.statistic << "," << histograms.degreesOfFreedom << "," << histograms.z()
+            << std::defaultfloat << std::endl;
+
+        if (!geometric.isOrdered)
+        {
+            std::cerr << "n = " << c.n << ", p = " << c.p << ": indices out of order or range" << std::endl;
+            isPassed = false;
+        }
+        if (positions.degreesOfFreedom == 0 || positions.z() > maxZ)
+        {
+            std::cerr << "n = " << c.n << ", p = " << c.p << ": per-position frequencies differ" << std::endl;
+            isPassed = false;
+        }
+        if (histograms.degreesOfFreedom == 0 || histograms.z() > maxZ)
+        {
+            std::cerr << "n = " << c.n << ", p = " << c.p << ": success-count histograms differ" << std::endl;
+            isPassed = false;
+        }
+    }
+
+    // The degenerate probabilities select nothing or everything
+    {
+        std::size_t count = 0;
+        Random::forEachBernoulliSuccess(10, 0.0, [&](std::size_t) { ++count; });
+        Random::forEachBernoulliSuccess(10, 1.0, [&](std::size_t i) { count += (i == count) ? 1 : 100; });
+        if (count != 10)
+        {
+            std::cerr << "p = 0 or p = 1 does not select nothing or everything" << std::endl;
+            isPassed = false;
+        }
+    }
+
+    std::cout << (isPassed ? "PASSED" : "FAILED") << std::endl;
+
+    return isPassed ? 0 : 1;
+}
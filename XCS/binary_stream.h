@@ -0,0 +1,284 @@
+#pragma once
+
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace XCS
+{
+
+    // Buffered writer of binary data (values in the byte order of the machine)
+    //   Small writes are gathered into a buffer that goes to the stream in one call
+    //   when full, and writes larger than the buffer go to the stream directly.
+    //   flush() must be called at the end to write out the rest of the buffer (the
+    //   destructor does so as well, but cannot report errors).
+    class BinaryWriter
+    {
+    private:
+        std::ostream & m_os;
+        std::vector<char> m_buffer;
+        std::size_t m_size;
+
+        void writeToStream(const void * data, std::size_t size)
+        {
+            if (!m_os.write(static_cast<const char *>(data), static_cast<std::streamsize>(size)))
+            {
+                throw std::runtime_error("Cannot write binary data");
+            }
+        }
+
+    public:
+        // Constructor
+        explicit BinaryWriter(std::ostream & os, std::size_t bufferSize = 65536) : m_os(os), m_buffer(std::max<std::size_t>(bufferSize, 1)), m_size(0) {}
+
+        BinaryWriter(const BinaryWriter &) = delete;
+        BinaryWriter & operator= (const BinaryWriter &) = delete;
+
+        // Destructor
+        ~BinaryWriter()
+        {
+            try
+            {
+                flush();
+            }
+            catch (const std::exception &)
+            {
+            }
+        }
+
+        // Throws std::runtime_error if the stream fails
+        void writeBytes(const void * data, std::size_t size)
+        {
+            if (size > m_buffer.size() - m_size)
+            {
+                flush();
+                if (size >= m_buffer.size())
+                {
+                    writeToStream(data, size);
+                    return;
+                }
+            }
+
+            std::memcpy(m_buffer.data() + m_size, data, size);
+            m_size += size;
+        }
+
+        template <typename U>
+        void write(const U & value)
+        {
+            static_assert(std::is_trivially_copyable<U>::value, "BinaryWriter::write() requires a trivially copyable type");
+            writeBytes(&value, sizeof(U));
+        }
+
+        // Writes the size followed by the elements
+        template <typename U>
+        void writeVector(const std::vector<U> & values)
+        {
+            static_assert(std::is_trivially_copyable<U>::value, "BinaryWriter::writeVector() requires a trivially copyable element type");
+            write<uint64_t>(values.size());
+            if (!values.empty())
+            {
+                writeBytes(values.data(), values.size() * sizeof(U));
+            }
+        }
+
+        // std::vector<bool> is written one byte per element
+        void writeVector(const std::vector<bool> & values)
+        {
+            write<uint64_t>(values.size());
+            for (bool value : values)
+            {
+                write<uint8_t>(value ? 1 : 0);
+            }
+        }
+
+        void flush()
+        {
+            if (m_size > 0)
+            {
+                std::size_t size = m_size;
+                m_size = 0;
+                writeToStream(m_buffer.data(), size);
+            }
+            if (!m_os.flush())
+            {
+                throw std::runtime_error("Cannot write binary data");
+            }
+        }
+    };
+
+    // Buffered reader of data written by BinaryWriter
+    //   The stream is read in buffer-sized chunks, so the reader may consume bytes
+    //   beyond the last value read from it. Lengths read from the data are checked
+    //   against the size of the rest of the stream before anything is allocated for
+    //   them (see readLength()), so corrupt data raises std::runtime_error instead of
+    //   huge allocations.
+    class BinaryReader
+    {
+    private:
+        std::istream & m_is;
+        std::vector<char> m_buffer;
+        std::size_t m_begin;
+        std::size_t m_end;
+
+        // The bytes left in the stream after the buffer (if the stream is seekable)
+        bool m_isStreamSizeKnown;
+        uint64_t m_streamRemainingSize;
+
+        [[noreturn]] static void throwEndOfStream()
+        {
+            throw std::runtime_error("Unexpected end of binary data");
+        }
+
+        void countStreamRead(std::size_t size)
+        {
+            m_streamRemainingSize -= std::min<uint64_t>(size, m_streamRemainingSize);
+        }
+
+    public:
+        // The largest length accepted by readLength() (in bytes) if the size of the
+        // stream is unknown, e.g. for a pipe
+        static constexpr uint64_t maxUnknownSizeLength = uint64_t(1) << 30;
+
+        // Constructor
+        explicit BinaryReader(std::istream & is, std::size_t bufferSize = 65536) :
+            m_is(is),
+            m_buffer(std::max<std::size_t>(bufferSize, 1)),
+            m_begin(0),
+            m_end(0),
+            m_isStreamSizeKnown(false),
+            m_streamRemainingSize(0)
+        {
+            auto position = m_is.tellg();
+            if (position != std::istream::pos_type(-1))
+            {
+                if (m_is.seekg(0, std::ios::end))
+                {
+                    auto endPosition = m_is.tellg();
+                    if (endPosition != std::istream::pos_type(-1) && endPosition >= position)
+                    {
+                        m_isStreamSizeKnown = true;
+                        m_streamRemainingSize = static_cast<uint64_t>(endPosition - position);
+                    }
+                }
+                m_is.clear();
+                m_is.seekg(position);
+            }
+        }
+
+        BinaryReader(const BinaryReader &) = delete;
+        BinaryReader & operator= (const BinaryReader &) = delete;
+
+        // Throws std::runtime_error if the stream ends before size bytes
+        void readBytes(void * data, std::size_t size)
+        {
+            char * dest = static_cast<char *>(data);
+            while (size > 0)
+            {
+                if (m_begin == m_end)
+                {
+                    // Large reads bypass the buffer
+                    if (size >= m_buffer.size())
+                    {
+                        if (!m_is.read(dest, static_cast<std::streamsize>(size)))
+                        {
+                            throwEndOfStream();
+                        }
+                        countStreamRead(size);
+                        return;
+                    }
+
+                    m_is.read(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+                    m_begin = 0;
+                    m_end = static_cast<std::size_t>(m_is.gcount());
+                    countStreamRead(m_end);
+                    if (m_end == 0)
+                    {
+                        throwEndOfStream();
+                    }
+                }
+
+                std::size_t count = std::min(size, m_end - m_begin);
+                std::memcpy(dest, m_buffer.data() + m_begin, count);
+                m_begin += count;
+                dest += count;
+                size -= count;
+            }
+        }
+
+        template <typename U>
+        void read(U & value)
+        {
+            static_assert(std::is_trivially_copyable<U>::value, "BinaryReader::read() requires a trivially copyable type");
+            readBytes(&value, sizeof(U));
+        }
+
+        // Any nonzero byte is true (loading another byte into a bool is undefined)
+        void read(bool & value)
+        {
+            value = (read<uint8_t>() != 0);
+        }
+
+        template <typename U>
+        U read()
+        {
+            U value;
+            read(value);
+            return value;
+        }
+
+        // Throws std::runtime_error if fewer than size bytes are left (checked only if
+        // the size of the stream is known; otherwise size may not exceed
+        // maxUnknownSizeLength)
+        void requireBytes(uint64_t size) const
+        {
+            if (m_isStreamSizeKnown ? (size > m_streamRemainingSize + (m_end - m_begin)) : (size > maxUnknownSizeLength))
+            {
+                throwEndOfStream();
+            }
+        }
+
+        // Reads the number of elements that follow in the data, each taking at least
+        // elementSize bytes
+        //   Throws std::runtime_error if the rest of the data cannot hold them (see
+        //   requireBytes()).
+        std::size_t readLength(std::size_t elementSize)
+        {
+            uint64_t length = read<uint64_t>();
+            if (elementSize > 0 && length > std::numeric_limits<uint64_t>::max() / elementSize)
+            {
+                throwEndOfStream();
+            }
+            requireBytes(length * elementSize);
+            return static_cast<std::size_t>(length);
+        }
+
+        template <typename U>
+        void readVector(std::vector<U> & values)
+        {
+            static_assert(std::is_trivially_copyable<U>::value, "BinaryReader::readVector() requires a trivially copyable element type");
+            values.resize(readLength(sizeof(U)));
+            if (!values.empty())
+            {
+                readBytes(values.data(), values.size() * sizeof(U));
+            }
+        }
+
+        void readVector(std::vector<bool> & values)
+        {
+            values.resize(readLength(1));
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                values[i] = (read<uint8_t>() != 0);
+            }
+        }
+    };
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "bits.h"
+#include "flat_index.h"
+
+namespace XCS
+{
+
+    // Bit-sliced match index over the population for binary conditions
+    //   Every classifier owns a slot. For each input bit position i and each bit value v,
+    //   the index keeps a bitset over the slots marking the classifiers whose allele i
+    //   accepts v (i.e. is v or "don't care"). The match set of a situation is the AND of
+    //   the L bitsets selected by its bits. The bitsets are stored block-major (the words
+    //   for slots [64w, 64w + 64) of all positions are adjacent) so that each block of 64
+    //   classifiers is resolved from contiguous memory and skipped as soon as it empties.
+    template <typename T, class Classifier>
+    class BitSlicedMatchIndex
+    {
+    protected:
+        using ClassifierPtr = std::shared_ptr<Classifier>;
+
+        // Condition length (set by the first insertion)
+        std::size_t m_length;
+
+        // m_bits[(w * m_length + i) * 2 + v]
+        std::vector<uint64_t> m_bits;
+
+        // Occupied slots for each block
+        std::vector<uint64_t> m_occupied;
+
+        std::vector<ClassifierPtr> m_slots;
+        std::vector<std::size_t> m_freeSlots;
+        FlatIndex<const Classifier *> m_slotIdxs;
+
+        uint64_t * block(std::size_t slotIdx)
+        {
+            return &m_bits[slotIdx / Bits::wordBitLength * m_length * 2];
+        }
+
+    public:
+        // Constructor
+        BitSlicedMatchIndex() : m_length(0) {}
+
+        template <class Constants>
+        explicit BitSlicedMatchIndex(const Constants &) : BitSlicedMatchIndex() {}
+
+        // Destructor
+        virtual ~BitSlicedMatchIndex() = default;
+
+        void insert(const ClassifierPtr & cl)
+        {
+            assert(m_slotIdxs.find(cl.get()) == FlatIndex<const Classifier *>::npos);
+
+            if (m_slotIdxs.empty() && m_length != cl->condition.size())
+            {
+                clear();
+                m_length = cl->condition.size();
+            }
+
+            assert(m_length == cl->condition.size());
+
+            std::size_t slotIdx;
+            if (m_freeSlots.empty())
+            {
+                slotIdx = m_slots.size();
+                m_slots.emplace_back();
+                if (slotIdx % Bits::wordBitLength == 0)
+                {
+                    m_bits.resize(m_bits.size() + m_length * 2, 0);
+                    m_occupied.push_back(0);
+                }
+            }
+            else
+            {
+                slotIdx = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+
+            m_slots[slotIdx] = cl;
+            m_slotIdxs.insert(cl.get(), slotIdx);
+
+            uint64_t mask = uint64_t(1) << (slotIdx % Bits::wordBitLength);
+            uint64_t * bits = block(slotIdx);
+            for (std::size_t i = 0; i < m_length; ++i)
+            {
+                auto && symbol = cl->condition.at(i);
+                if (symbol.isDontCare() || !symbol.value())
+                {
+                    bits[i * 2] |= mask;
+                }
+                if (symbol.isDontCare() || symbol.value())
+                {
+                    bits[i * 2 + 1] |= mask;
+                }
+            }
+            m_occupied[slotIdx / Bits::wordBitLength] |= mask;
+        }
+
+        void erase(const ClassifierPtr & cl)
+        {
+            std::size_t slotIdx = m_slotIdxs.find(cl.get());
+            if (slotIdx == FlatIndex<const Classifier *>::npos)
+            {
+                return;
+            }
+
+            m_slotIdxs.erase(cl.get(), slotIdx);
+
+            uint64_t mask = uint64_t(1) << (slotIdx % Bits::wordBitLength);
+            uint64_t * bits = block(slotIdx);
+            for (std::size_t i = 0; i < m_length * 2; ++i)
+            {
+                bits[i] &= ~mask;
+            }
+            m_occupied[slotIdx / Bits::wordBitLength] &= ~mask;
+
+            m_slots[slotIdx].reset();
+            m_freeSlots.push_back(slotIdx);
+        }
+
+        void clear()
+        {
+            m_bits.clear();
+            m_occupied.clear();
+            m_slots.clear();
+            m_freeSlots.clear();
+            m_slotIdxs.clear();
+        }
+
+        // Calls f for each indexed classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            assert(m_slotIdxs.empty() || m_length == situation.size());
+
+            const uint64_t * bits = m_bits.data();
+            for (std::size_t w = 0; w < m_occupied.size(); ++w, bits += m_length * 2)
+            {
+                uint64_t result = m_occupied[w];
+                for (std::size_t i = 0; i < m_length && result != 0; ++i)
+                {
+                    result &= bits[i * 2 + (situation[i] ? 1 : 0)];
+                }
+
+                while (result != 0)
+                {
+                    f(m_slots[w * Bits::wordBitLength + Bits::countTrailingZeros(result)]);
+                    result &= result - 1;
+                }
+            }
+        }
+    };
+
+}
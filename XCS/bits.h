@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace XCS
+{
+
+    // Helpers for the word-level operations on packed bit strings
+    namespace Bits
+    {
+
+        // The number of bits in a word
+        constexpr std::size_t wordBitLength = 64;
+
+        // Returns the number of words needed to hold the given number of bits
+        constexpr std::size_t wordCount(std::size_t bitLength)
+        {
+            return (bitLength + wordBitLength - 1) / wordBitLength;
+        }
+
+        // Returns the mask of the valid bits in the last word of a bit string
+        constexpr uint64_t lastWordMask(std::size_t bitLength)
+        {
+            return (bitLength % wordBitLength == 0) ? ~uint64_t(0) : (uint64_t(1) << (bitLength % wordBitLength)) - 1;
+        }
+
+        // Returns the mask of the bits [from, to) inside the word whose first bit is wordBegin
+        inline uint64_t rangeMask(std::size_t wordBegin, std::size_t from, std::size_t to)
+        {
+            std::size_t begin = (from > wordBegin) ? from - wordBegin : 0;
+            std::size_t end = (to < wordBegin + wordBitLength) ? to - wordBegin : wordBitLength;
+
+            if (to <= wordBegin || begin >= end)
+            {
+                return 0;
+            }
+
+            uint64_t upper = (end == wordBitLength) ? ~uint64_t(0) : (uint64_t(1) << end) - 1;
+            uint64_t lower = (uint64_t(1) << begin) - 1;
+            return upper & ~lower;
+        }
+
+        inline std::size_t popCount(uint64_t word)
+        {
+#if defined(__GNUC__)
+            return static_cast<std::size_t>(__builtin_popcountll(word));
+#else
+            word = word - ((word >> 1) & 0x5555555555555555ULL);
+            word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+            word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            return static_cast<std::size_t>((word * 0x0101010101010101ULL) >> 56);
+#endif
+        }
+
+        // Returns the index of the lowest set bit (word must not be zero)
+        inline std::size_t countTrailingZeros(uint64_t word)
+        {
+#if defined(__GNUC__)
+            return static_cast<std::size_t>(__builtin_ctzll(word));
+#elif defined(_MSC_VER) && defined(_M_X64)
+            unsigned long idx;
+            _BitScanForward64(&idx, word);
+            return static_cast<std::size_t>(idx);
+#else
+            return popCount((word & (~word + 1)) - 1);
+#endif
+        }
+
+    }
+
+}
@@ -4,8 +4,12 @@
 #include <string>
 #include <cstdint>
 #include <cstddef>
+#include <cmath>
+#include <stdexcept>
 #include <cassert>
 
+#include "binary_stream.h"
+
 namespace XCS
 {
 
@@ -92,6 +96,12 @@ namespace XCS
         //   classifier - represents.
         uint64_t numerosity;
 
+        // Slot of the classifier in the population that last inserted it (a hint kept by
+        //   Population, which checks it against its own slots before use)
+        std::size_t populationSlotIdx;
+
+        using ConditionActionPair::condition;
+        using ConditionActionPair::action;
         using ConditionActionPair::isMoreGeneral;
 
     protected:
@@ -110,6 +120,7 @@ namespace XCS
             timeStamp(obj.timeStamp),
             actionSetSize(obj.actionSetSize),
             numerosity(obj.numerosity),
+            populationSlotIdx(~std::size_t(0)),
             m_thetaSub(obj.m_thetaSub),
             m_predictionErrorThreshold(obj.m_predictionErrorThreshold)
         {
@@ -124,6 +135,7 @@ namespace XCS
             timeStamp(timeStamp),
             actionSetSize(1),
             numerosity(1),
+            populationSlotIdx(~std::size_t(0)),
             m_thetaSub(constants.thetaSub),
             m_predictionErrorThreshold(constants.predictionErrorThreshold)
         {
@@ -148,6 +160,40 @@ namespace XCS
             return experience > m_thetaSub && predictionError < m_predictionErrorThreshold;
         }
 
+        // Writes the condition, the action and the parameters
+        virtual void write(BinaryWriter & writer) const
+        {
+            condition.write(writer);
+            writer.write(action);
+            writer.write(prediction);
+            writer.write(predictionError);
+            writer.write(fitness);
+            writer.write(experience);
+            writer.write(timeStamp);
+            writer.write(actionSetSize);
+            writer.write(numerosity);
+        }
+
+        // Reads what write() wrote (the constants of the classifier are kept)
+        virtual void read(BinaryReader & reader)
+        {
+            condition.read(reader);
+            reader.read(action);
+            reader.read(prediction);
+            reader.read(predictionError);
+            reader.read(fitness);
+            reader.read(experience);
+            reader.read(timeStamp);
+            reader.read(actionSetSize);
+            reader.read(numerosity);
+
+            if (!std::isfinite(prediction) || !(predictionError >= 0.0 && std::isfinite(predictionError)) || !(fitness > 0.0 && std::isfinite(fitness))
+                || !(experience >= 0.0) || !(actionSetSize > 0.0 && std::isfinite(actionSetSize)) || numerosity == 0)
+            {
+                throw std::runtime_error("Invalid classifier data");
+            }
+        }
+
         // DOES SUBSUME
         virtual bool subsumes(const Classifier<T, Action, Symbol, Condition, ConditionActionPair, Constants> & cl) const
         {
@@ -1,10 +1,25 @@
 #pragma once
 
+#include <memory>
+#include <vector>
 #include <unordered_set>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+#include "action_index.h"
 
 namespace XCS
 {
 
+    // Set of classifiers stored in a contiguous vector
+    //   Iteration follows insertion order (with swap-erase moving the last element into
+    //   the removed position), which does not depend on heap addresses. clear() keeps
+    //   the capacity, so sets regenerated every step stop allocating once they have
+    //   reached their largest size. insert() does not check membership: callers insert
+    //   classifiers that are not in the set yet, as the match set (from [P]) and the
+    //   action set (from [M]) do. The elements are shared_ptrs, so inserting and
+    //   clearing update atomic reference counts.
     template <typename Action, class Classifier, class Constants>
     class ClassifierPtrSet
     {
@@ -13,27 +28,35 @@ namespace XCS
 
         const Constants m_constants;
         const std::unordered_set<Action> m_availableActions;
+        const ActionIndex<Action> m_actionIndex;
 
-        std::unordered_set<ClassifierPtr> m_set;
+        std::vector<ClassifierPtr> m_set;
 
     public:
         // Constructor
         ClassifierPtrSet(const Constants & constants, const std::unordered_set<Action> availableActions) :
             m_constants(constants),
-            m_availableActions(availableActions)
+            m_availableActions(availableActions),
+            m_actionIndex(availableActions)
         {
         }
 
         ClassifierPtrSet(const std::unordered_set<ClassifierPtr> & set, const Constants & constants, const std::unordered_set<Action> availableActions) :
-            m_set(set),
             m_constants(constants),
-            m_availableActions(availableActions)
+            m_availableActions(availableActions),
+            m_actionIndex(availableActions),
+            m_set(set.begin(), set.end())
         {
         }
 
         // Destructor
         virtual ~ClassifierPtrSet() = default;
 
+        const ActionIndex<Action> & actionIndex() const noexcept
+        {
+            return m_actionIndex;
+        }
+
         auto empty() const noexcept
         {
             return m_set.empty();
@@ -64,16 +87,35 @@ namespace XCS
             return m_set.cend();
         }
 
-        template <class... Args>
-        auto insert(Args... args)
+        void insert(const ClassifierPtr & cl)
         {
-            return m_set.insert(args...);
+            assert(std::find(m_set.begin(), m_set.end(), cl) == m_set.end());
+
+            m_set.push_back(cl);
+        }
+
+        // Removes the classifier at position idx in O(1) (the last one takes its place)
+        void eraseAt(std::size_t idx)
+        {
+            assert(idx < m_set.size());
+
+            if (idx + 1 != m_set.size())
+            {
+                m_set[idx] = std::move(m_set.back());
+            }
+            m_set.pop_back();
         }
 
-        template <class... Args>
-        auto erase(Args... args)
+        std::size_t erase(const ClassifierPtr & cl)
         {
-            return m_set.erase(args...);
+            auto it = std::find(m_set.begin(), m_set.end(), cl);
+            if (it == m_set.end())
+            {
+                return 0;
+            }
+
+            eraseAt(it - m_set.begin());
+            return 1;
         }
 
         void clear() noexcept
@@ -81,23 +123,20 @@ namespace XCS
             m_set.clear();
         }
 
-        template <class... Args>
-        void swap(Args... args)
+        void swap(ClassifierPtrSet & obj) noexcept
         {
-            m_set.swap(args...);
+            m_set.swap(obj.m_set);
         }
 
-        template <class... Args>
-        auto find(Args... args) const
+        auto find(const ClassifierPtr & cl) const
         {
-            return m_set.find(args...);
+            return std::find(m_set.begin(), m_set.end(), cl);
         }
 
-        template <class... Args>
-        auto count(Args... args) const
+        std::size_t count(const ClassifierPtr & cl) const
         {
-            return m_set.count(args...);
+            return (find(cl) == m_set.end()) ? 0 : 1;
         }
     };
 
-}
\ No newline at end of file
+}
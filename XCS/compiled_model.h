@@ -0,0 +1,389 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "mapped_file.h"
+#include "packed_condition.h"
+#include "prediction_array.h"
+
+namespace XCS
+{
+
+    // File layout of a compiled model (native byte order, every section 8-byte aligned)
+    //   CompiledModelHeader
+    //   CompiledActionGroup        x actionCount
+    //   CompiledClassifierWeights  x classifierCount (grouped by action)
+    //   condition elements         x classifierCount * conditionStride (8 bytes each)
+    //   The classifiers of each action are stored contiguously, so matching needs no
+    //   per-classifier action lookup, and only what the prediction array needs is kept.
+
+    enum class CompiledConditionKind : uint32_t
+    {
+        // conditionStride = 2 * wordCount uint64_t: the care words, then the value words
+        // of a packed ternary condition (see PackedCondition)
+        Ternary = 1,
+
+        // conditionStride = 2 * situationLength doubles: the lower bounds, then the
+        // upper bounds of the intervals [lower, upper)
+        Interval = 2,
+    };
+
+    struct CompiledModelHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t conditionKind;
+        uint64_t situationLength;
+        uint64_t conditionStride;
+        uint64_t actionCount;
+        uint64_t classifierCount;
+        uint64_t flags;
+        uint64_t reserved;
+
+        static constexpr const char * magicString() { return "XCSMODEL"; }
+        static constexpr uint32_t currentVersion = 1;
+
+        // Classifiers are sorted by decreasing numerosity within each action group
+        static constexpr uint64_t sortedByNumerosityFlag = 1;
+    };
+
+    struct CompiledActionGroup
+    {
+        int64_t action;
+        uint64_t firstClassifierIdx;
+        uint64_t classifierCount;
+        uint64_t reserved;
+    };
+
+    struct CompiledClassifierWeights
+    {
+        double prediction;
+        double fitness;
+    };
+
+    // A classifier on its way into a compiled model
+    template <typename Element>
+    struct CompiledClassifier
+    {
+        std::size_t actionIdx;
+        uint64_t numerosity;
+        CompiledClassifierWeights weights;
+        std::vector<Element> condition;
+    };
+
+    // Writes a compiled model file
+    //   Throws std::runtime_error if the file cannot be written.
+    template <typename Action, typename Element>
+    void writeCompiledModel(const std::string & filename, CompiledConditionKind conditionKind, std::size_t situationLength, std::size_t conditionStride, const std::vector<Action> & actions, std::vector<CompiledClassifier<Element>> classifiers, bool sortsByNumerosity)
+    {
+        static_assert(std::is_integral<Action>::value, "Compiled models store integral actions");
+        static_assert(sizeof(Element) == 8, "Condition elements must be 8 bytes");
+
+        std::stable_sort(classifiers.begin(), classifiers.end(), [sortsByNumerosity](const CompiledClassifier<Element> & lhs, const CompiledClassifier<Element> & rhs) {
+            if (lhs.actionIdx != rhs.actionIdx)
+            {
+                return lhs.actionIdx < rhs.actionIdx;
+            }
+            return sortsByNumerosity && lhs.numerosity > rhs.numerosity;
+        });
+
+        CompiledModelHeader header = {};
+        std::memcpy(header.magic, CompiledModelHeader::magicString(), sizeof(header.magic));
+        header.version = CompiledModelHeader::currentVersion;
+        header.conditionKind = static_cast<uint32_t>(conditionKind);
+        header.situationLength = situationLength;
+        header.conditionStride = conditionStride;
+        header.actionCount = actions.size();
+        header.classifierCount = classifiers.size();
+        header.flags = sortsByNumerosity ? CompiledModelHeader::sortedByNumerosityFlag : 0;
+
+        std::vector<CompiledActionGroup> groups(actions.size());
+        for (std::size_t i = 0; i < actions.size(); ++i)
+        {
+            groups[i] = { static_cast<int64_t>(actions[i]), 0, 0, 0 };
+        }
+        for (std::size_t i = classifiers.size(); i-- > 0;)
+        {
+            groups[classifiers[i].actionIdx].firstClassifierIdx = i;
+            ++groups[classifiers[i].actionIdx].classifierCount;
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        if (!file)
+        {
+            throw std::runtime_error("Cannot open " + filename);
+        }
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(groups.data()), groups.size() * sizeof(CompiledActionGroup));
+        for (auto && cl : classifiers)
+        {
+            file.write(reinterpret_cast<const char *>(&cl.weights), sizeof(cl.weights));
+        }
+        for (auto && cl : classifiers)
+        {
+            assert(cl.condition.size() == conditionStride);
+            file.write(reinterpret_cast<const char *>(cl.condition.data()), conditionStride * sizeof(Element));
+        }
+
+        if (!file.flush())
+        {
+            throw std::runtime_error("Cannot write " + filename);
+        }
+    }
+
+    // Read-only model loaded from a compiled model file
+    //   The file is memory-mapped and used in place: loading only validates the header
+    //   and section sizes, and every process serving the same file shares its pages.
+    //   Derived models interpret the condition section (see CompiledConditionKind).
+    template <typename Action, typename Element>
+    class AbstractCompiledModel
+    {
+    protected:
+        MappedFile m_file;
+        const CompiledModelHeader * m_header;
+        const CompiledActionGroup * m_groups;
+        const CompiledClassifierWeights * m_weights;
+        const Element * m_conditions;
+        std::vector<Action> m_actions;
+
+        // Situations are matched in blocks of this size against each classifier
+        static constexpr std::size_t situationBlockSize = 256;
+
+        // Accumulates the sums of the classifiers matching each situation of a block
+        //   matches(conditionElements, blockIdx) tests the condition of a classifier
+        //   against a situation of the block.
+        template <class MatchFunction>
+        void accumulateBlock(std::size_t firstSituationIdx, std::size_t blockSize, MatchFunction matches, std::vector<PredictionArraySums> & sums) const
+        {
+            std::size_t actionCount = m_actions.size();
+            for (std::size_t i = 0; i < actionCount; ++i)
+            {
+                auto && group = m_groups[i];
+                for (std::size_t j = group.firstClassifierIdx; j < group.firstClassifierIdx + group.classifierCount; ++j)
+                {
+                    const Element * condition = m_conditions + j * m_header->conditionStride;
+                    double predictionTerm = m_weights[j].prediction * m_weights[j].fitness;
+                    double fitness = m_weights[j].fitness;
+                    for (std::size_t k = 0; k < blockSize; ++k)
+                    {
+                        if (matches(condition, k))
+                        {
+                            auto && actionSums = sums[(firstSituationIdx + k) * actionCount + i];
+                            actionSums.predictionSum += predictionTerm;
+                            actionSums.fitnessSum += fitness;
+                            actionSums.isCovered = true;
+                        }
+                    }
+                }
+            }
+        }
+
+    public:
+        // Constructor
+        //   Throws std::runtime_error if the file is not a compiled model of the given kind
+        AbstractCompiledModel(const std::string & filename, CompiledConditionKind conditionKind) : m_file(filename)
+        {
+            auto error = [&filename](const std::string & message) {
+                return std::runtime_error(filename + ": " + message);
+            };
+
+            if (m_file.size() < sizeof(CompiledModelHeader))
+            {
+                throw error("Not a compiled model");
+            }
+
+            m_header = reinterpret_cast<const CompiledModelHeader *>(m_file.data());
+            if (std::memcmp(m_header->magic, CompiledModelHeader::magicString(), sizeof(m_header->magic)) != 0)
+            {
+                throw error("Not a compiled model");
+            }
+            if (m_header->version != CompiledModelHeader::currentVersion)
+            {
+                throw error("Unsupported model version " + std::to_string(m_header->version));
+            }
+            if (m_header->conditionKind != static_cast<uint32_t>(conditionKind))
+            {
+                throw error("Unexpected condition kind");
+            }
+
+            // predict() reads conditions of the stride implied by the situation length
+            //   (care and value words for Ternary, lower and upper bounds for Interval)
+            uint64_t elementCount = (conditionKind == CompiledConditionKind::Ternary) ? (m_header->situationLength + Bits::wordBitLength - 1) / Bits::wordBitLength : m_header->situationLength;
+            if (m_header->situationLength > std::numeric_limits<uint64_t>::max() / 2 || m_header->conditionStride != elementCount * 2)
+            {
+                throw error("Condition stride does not match the situation length");
+            }
+
+            // Check the section sizes without overflowing
+            std::size_t remainingSize = m_file.size() - sizeof(CompiledModelHeader);
+            if (m_header->actionCount > remainingSize / sizeof(CompiledActionGroup))
+            {
+                throw error("Truncated model");
+            }
+            remainingSize -= m_header->actionCount * sizeof(CompiledActionGroup);
+            if (m_header->classifierCount > remainingSize / sizeof(CompiledClassifierWeights))
+            {
+                throw error("Truncated model");
+            }
+            remainingSize -= m_header->classifierCount * sizeof(CompiledClassifierWeights);
+            if (m_header->conditionStride > 0 && m_header->classifierCount > remainingSize / sizeof(Element) / m_header->conditionStride)
+            {
+                throw error("Truncated model");
+            }
+
+            m_groups = reinterpret_cast<const CompiledActionGroup *>(m_file.data() + sizeof(CompiledModelHeader));
+            m_weights = reinterpret_cast<const CompiledClassifierWeights *>(m_groups + m_header->actionCount);
+            m_conditions = reinterpret_cast<const Element *>(m_weights + m_header->classifierCount);
+
+            for (std::size_t i = 0; i < m_header->actionCount; ++i)
+            {
+                if (m_groups[i].firstClassifierIdx > m_header->classifierCount || m_groups[i].classifierCount > m_header->classifierCount - m_groups[i].firstClassifierIdx)
+                {
+                    throw error("Invalid action group");
+                }
+                m_actions.push_back(static_cast<Action>(m_groups[i].action));
+            }
+        }
+
+        // Destructor
+        virtual ~AbstractCompiledModel() = default;
+
+        std::size_t situationLength() const noexcept
+        {
+            return m_header->situationLength;
+        }
+
+        std::size_t classifierCount() const noexcept
+        {
+            return m_header->classifierCount;
+        }
+
+        // The actions in the order of the prediction arrays
+        const std::vector<Action> & actions() const noexcept
+        {
+            return m_actions;
+        }
+    };
+
+    template <typename Action, typename Element>
+    constexpr std::size_t AbstractCompiledModel<Action, Element>::situationBlockSize;
+
+    // Compiled model of a binary XCS population (conditions packed as in PackedCondition)
+    template <typename Action = bool>
+    class CompiledModel : public AbstractCompiledModel<Action, uint64_t>
+    {
+    private:
+        using AbstractCompiledModel<Action, uint64_t>::m_header;
+        using AbstractCompiledModel<Action, uint64_t>::m_actions;
+        using AbstractCompiledModel<Action, uint64_t>::situationBlockSize;
+        using AbstractCompiledModel<Action, uint64_t>::accumulateBlock;
+
+    public:
+        // Constructor
+        explicit CompiledModel(const std::string & filename) :
+            AbstractCompiledModel<Action, uint64_t>(filename, CompiledConditionKind::Ternary)
+        {
+        }
+
+        // Compiles the population of a binary XCS into a model file
+        //   Works with any condition providing size() and at(idx) (the symbols), e.g.
+        //   Condition<bool, Symbol<bool>> and PackedCondition. sortsByNumerosity puts the
+        //   most numerous classifiers of each action first.
+        template <class Population>
+        static void compile(const Population & population, const std::string & filename, bool sortsByNumerosity = false)
+        {
+            auto && actionIndex = population.actionIndex();
+
+            std::size_t situationLength = population.size() > 0 ? (*population.begin())->condition.size() : 0;
+            std::size_t wordCount = Bits::wordCount(situationLength);
+
+            std::vector<CompiledClassifier<uint64_t>> classifiers;
+            for (auto && cl : population)
+            {
+                assert(cl->condition.size() == situationLength);
+
+                CompiledClassifier<uint64_t> compiledClassifier = { actionIndex.idx(cl->action), cl->numerosity, { cl->prediction, cl->fitness }, std::vector<uint64_t>(wordCount * 2, 0) };
+                for (std::size_t i = 0; i < situationLength; ++i)
+                {
+                    auto && symbol = cl->condition.at(i);
+                    if (!symbol.isDontCare())
+                    {
+                        uint64_t bit = uint64_t(1) << (i % Bits::wordBitLength);
+                        compiledClassifier.condition[i / Bits::wordBitLength] |= bit;
+                        if (symbol.value())
+                        {
+                            compiledClassifier.condition[wordCount + i / Bits::wordBitLength] |= bit;
+                        }
+                    }
+                }
+                classifiers.push_back(std::move(compiledClassifier));
+            }
+
+            writeCompiledModel(filename, CompiledConditionKind::Ternary, situationLength, wordCount * 2, actionIndex.actions(), std::move(classifiers), sortsByNumerosity);
+        }
+
+        // Returns the action with the highest prediction for each situation and stores
+        // the prediction arrays in predictionArrays[situationIdx * actions().size() + i]
+        // (same selection as Experiment::predict(), with ties broken at random with random)
+        //   Throws std::invalid_argument if a situation is not of situationLength().
+        std::vector<Action> predict(const std::vector<std::vector<bool>> & situations, std::vector<double> & predictionArrays, RandomEngine & random) const
+        {
+            std::size_t wordCount = m_header->conditionStride / 2;
+
+            std::vector<PredictionArraySums> sums(situations.size() * m_actions.size(), PredictionArraySums{ 0.0, 0.0, false });
+            std::vector<uint64_t> packedSituations;
+            for (std::size_t begin = 0; begin < situations.size(); begin += situationBlockSize)
+            {
+                std::size_t blockSize = std::min(situationBlockSize, situations.size() - begin);
+
+                packedSituations.clear();
+                for (std::size_t i = begin; i < begin + blockSize; ++i)
+                {
+                    if (situations[i].size() != m_header->situationLength)
+                    {
+                        throw std::invalid_argument("Expected situations of length " + std::to_string(m_header->situationLength));
+                    }
+                    auto words = PackedCondition::prepareSituation(situations[i]);
+                    packedSituations.insert(packedSituations.end(), words.begin(), words.end());
+                }
+
+                accumulateBlock(begin, blockSize, [&](const uint64_t * condition, std::size_t blockIdx) {
+                    const uint64_t * situation = packedSituations.data() + blockIdx * wordCount;
+                    for (std::size_t i = 0; i < wordCount; ++i)
+                    {
+                        if (((situation[i] ^ condition[wordCount + i]) & condition[i]) != 0)
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }, sums);
+            }
+
+            return selectGreedyActions(m_actions, sums, predictionArrays, random);
+        }
+
+        std::vector<Action> predict(const std::vector<std::vector<bool>> & situations, RandomEngine & random) const
+        {
+            std::vector<double> predictionArrays;
+            return predict(situations, predictionArrays, random);
+        }
+
+        Action predict(const std::vector<bool> & situation, RandomEngine & random) const
+        {
+            return predict(std::vector<std::vector<bool>>{ situation }, random)[0];
+        }
+    };
+
+}
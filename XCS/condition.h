@@ -3,11 +3,14 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <cstddef>
 #include <cassert>
 #include <iterator>
 
 #include "random.h"
+#include "hash.h"
+#include "binary_stream.h"
 
 namespace XCS
 {
@@ -19,6 +22,9 @@ namespace XCS
         std::vector<Symbol> m_symbols;
 
     public:
+        // The form of a situation accepted by matches()
+        using Situation = std::vector<T>;
+
         // Constructor
         Condition() = default;
 
@@ -37,6 +43,13 @@ namespace XCS
         // Destructor
         virtual ~Condition() = default;
 
+        // Converts a situation into the form accepted by matches()
+        // (call once per situation when matching it against many conditions)
+        static const Situation & prepareSituation(const std::vector<T> & situation)
+        {
+            return situation;
+        }
+
         virtual std::string toString() const
         {
             std::string str;
@@ -52,6 +65,12 @@ namespace XCS
             return m_symbols[idx];
         }
 
+        // Updates what a derived condition computes from the symbols, after they were
+        // modified through operator[] (nothing to update here)
+        virtual void refresh()
+        {
+        }
+
         virtual const Symbol & at(std::size_t idx) const
         {
             return m_symbols.at(idx);
@@ -72,6 +91,17 @@ namespace XCS
             return lhs.m_symbols != rhs.m_symbols;
         }
 
+        // Returns the same value for equal conditions
+        virtual std::size_t hash() const
+        {
+            std::size_t seed = m_symbols.size();
+            for (auto && symbol : m_symbols)
+            {
+                seed = hashCombine(seed, symbol.hash());
+            }
+            return seed;
+        }
+
         // DOES MATCH
         virtual bool matches(const std::vector<T> & situation) const
         {
@@ -120,13 +150,9 @@ namespace XCS
 
         virtual void randomGeneralize(double generalizeProbability)
         {
-            for (auto && symbol : m_symbols)
-            {
-                if (Random::nextDouble() < generalizeProbability)
-                {
-                    symbol.generalize();
-                }
-            }
+            Random::forEachBernoulliSuccess(m_symbols.size(), generalizeProbability, [&](std::size_t i) {
+                m_symbols[i].generalize();
+            });
         }
 
         virtual std::size_t dontCareCount() const
@@ -142,6 +168,28 @@ namespace XCS
 
             return count;
         }
+
+        // Writes the number of symbols followed by the symbols
+        virtual void write(BinaryWriter & writer) const
+        {
+            writer.write<uint64_t>(m_symbols.size());
+            for (auto && symbol : m_symbols)
+            {
+                symbol.write(writer);
+            }
+        }
+
+        virtual void read(BinaryReader & reader)
+        {
+            std::size_t size = reader.readLength(1);
+            m_symbols.clear();
+            m_symbols.reserve(size);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                m_symbols.emplace_back(T());
+                m_symbols.back().read(reader);
+            }
+        }
     };
 
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <string>
+#include <stdexcept>
 #include <cstdint>
+#include <cstddef>
 
 namespace XCS
 {
@@ -114,6 +117,104 @@ namespace XCS
         bool doActionSetSubsumption = true;
 
         virtual ~Constants() = default;
+
+        // Sets the constant named by its member name (e.g. "thetaGA") from its text form
+        //   Returns false if there is no such constant and throws std::invalid_argument if
+        //   the value cannot be parsed.
+        virtual bool set(const std::string & name, const std::string & value)
+        {
+            return assignIfNamed(name, value, "maxPopulationClassifierCount", maxPopulationClassifierCount)
+                || assignIfNamed(name, value, "learningRate", learningRate)
+                || assignIfNamed(name, value, "alpha", alpha)
+                || assignIfNamed(name, value, "predictionErrorThreshold", predictionErrorThreshold)
+                || assignIfNamed(name, value, "nu", nu)
+                || assignIfNamed(name, value, "gamma", gamma)
+                || assignIfNamed(name, value, "thetaGA", thetaGA)
+                || assignIfNamed(name, value, "crossoverProbability", crossoverProbability)
+                || assignIfNamed(name, value, "mutationProbability", mutationProbability)
+                || assignIfNamed(name, value, "thetaDel", thetaDel)
+                || assignIfNamed(name, value, "delta", delta)
+                || assignIfNamed(name, value, "thetaSub", thetaSub)
+                || assignIfNamed(name, value, "generalizeProbability", generalizeProbability)
+                || assignIfNamed(name, value, "initialPrediction", initialPrediction)
+                || assignIfNamed(name, value, "initialPredictionError", initialPredictionError)
+                || assignIfNamed(name, value, "initialFitness", initialFitness)
+                || assignIfNamed(name, value, "exploreProbability", exploreProbability)
+                || assignIfNamed(name, value, "thetaMna", thetaMna)
+                || assignIfNamed(name, value, "doGASubsumption", doGASubsumption)
+                || assignIfNamed(name, value, "doActionSetSubsumption", doActionSetSubsumption);
+        }
+
+    protected:
+        static std::invalid_argument invalidValue(const std::string & name, const std::string & value)
+        {
+            return std::invalid_argument("Invalid value for " + name + ": \"" + value + "\"");
+        }
+
+        static void parse(const std::string & name, const std::string & value, uint64_t & result)
+        {
+            std::size_t length = 0;
+            try
+            {
+                result = std::stoull(value, &length);
+            }
+            catch (const std::exception &)
+            {
+                throw invalidValue(name, value);
+            }
+
+            if (length != value.size() || value[0] == '-')
+            {
+                throw invalidValue(name, value);
+            }
+        }
+
+        static void parse(const std::string & name, const std::string & value, double & result)
+        {
+            std::size_t length = 0;
+            try
+            {
+                result = std::stod(value, &length);
+            }
+            catch (const std::exception &)
+            {
+                throw invalidValue(name, value);
+            }
+
+            if (length != value.size())
+            {
+                throw invalidValue(name, value);
+            }
+        }
+
+        static void parse(const std::string & name, const std::string & value, bool & result)
+        {
+            if (value == "true" || value == "1")
+            {
+                result = true;
+            }
+            else if (value == "false" || value == "0")
+            {
+                result = false;
+            }
+            else
+            {
+                throw invalidValue(name, value);
+            }
+        }
+
+        // Parses value into member and returns true if name is memberName
+        template <typename U>
+        static bool assignIfNamed(const std::string & name, const std::string & value, const char * memberName, U & member)
+        {
+            if (name != memberName)
+            {
+                return false;
+            }
+
+            parse(name, value, member);
+            return true;
+        }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+
+#include "dataset.h"
+
+using namespace XCS;
+
+// Usage: xcs_convert_dataset <bits|reals> <input.csv> <output dataset>
+//   Converts CSV rows "x1,x2,...,xL,label" into the binary dataset format read by
+//   DatasetEnvironment (see convertCsvToDataset()).
+int main(int argc, char * argv[])
+{
+    if (argc != 4 || (std::string(argv[1]) != "bits" && std::string(argv[1]) != "reals"))
+    {
+        std::cerr << "Usage: " << argv[0] << " <bits|reals> <input.csv> <output dataset>" << std::endl;
+        return 1;
+    }
+
+    DatasetKind kind = (std::string(argv[1]) == "bits") ? DatasetKind::Bits : DatasetKind::Reals;
+
+    std::ifstream csv(argv[2]);
+    if (!csv)
+    {
+        std::cerr << "Cannot open " << argv[2] << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        std::size_t rowCount = convertCsvToDataset(csv, argv[3], kind);
+        std::cout << rowCount << " rows written to " << argv[3] << std::endl;
+    }
+    catch (const std::exception & e)
+    {
+        std::cerr << argv[2] << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,478 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <istream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "bits.h"
+#include "mapped_file.h"
+#include "binary_stream.h"
+
+namespace XCS
+{
+
+    // File layout of a dataset (native byte order, every section 8-byte aligned)
+    //   DatasetHeader
+    //   rows                       x rowCount (rowStride bytes each)
+    //   labels (int64_t)           x labelCount (the distinct labels in increasing order)
+    //   A row is the situation followed by its label (int64_t), the correct action.
+    //   Rows are fixed-width, so row i is found at rowOffset + i * rowStride without an
+    //   index, and the labels at the end let the rows be written in one pass.
+
+    enum class DatasetKind : uint32_t
+    {
+        // wordCount uint64_t per situation: bit i is bit i % 64 of word i / 64 (the
+        // packed situation of PackedCondition)
+        Bits = 1,
+
+        // situationLength doubles per situation
+        Reals = 2,
+    };
+
+    struct DatasetHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t kind;
+        uint64_t situationLength;
+        uint64_t rowStride;
+        uint64_t rowCount;
+        uint64_t rowOffset;
+        uint64_t labelOffset;
+        uint64_t labelCount;
+
+        static constexpr const char * magicString() { return "XCSDATA"; }
+        static constexpr uint32_t currentVersion = 1;
+
+        static std::size_t situationSize(DatasetKind kind, std::size_t situationLength)
+        {
+            return (kind == DatasetKind::Bits) ? Bits::wordCount(situationLength) * sizeof(uint64_t) : situationLength * sizeof(double);
+        }
+    };
+
+    static_assert(sizeof(DatasetHeader) == 64, "DatasetHeader must be 64 bytes");
+
+    // Writes a dataset file row by row
+    //   Rows are streamed through a BinaryWriter, and the header and the labels are
+    //   written by close(), so a file whose writer is destroyed without close() (e.g.
+    //   by an exception) is not a valid dataset.
+    class DatasetWriter
+    {
+    private:
+        const std::string m_filename;
+        std::ofstream m_file;
+        BinaryWriter m_writer;
+        DatasetHeader m_header;
+        std::set<int64_t> m_labels;
+        std::vector<uint64_t> m_words;
+        bool m_isClosed;
+
+        void writeLabel(int64_t label)
+        {
+            m_writer.write(label);
+            m_labels.insert(label);
+            ++m_header.rowCount;
+        }
+
+    public:
+        // Constructor
+        //   Throws std::runtime_error if the file cannot be opened
+        DatasetWriter(const std::string & filename, DatasetKind kind, std::size_t situationLength) :
+            m_filename(filename),
+            m_file(filename, std::ios::binary),
+            m_writer(m_file),
+            m_header(),
+            m_isClosed(false)
+        {
+            if (!m_file)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            m_header.version = DatasetHeader::currentVersion;
+            m_header.kind = static_cast<uint32_t>(kind);
+            m_header.situationLength = situationLength;
+            m_header.rowStride = DatasetHeader::situationSize(kind, situationLength) + sizeof(int64_t);
+            m_header.rowOffset = sizeof(DatasetHeader);
+
+            // Placeholder (without the magic) until close()
+            m_writer.write(m_header);
+        }
+
+        DatasetWriter(const DatasetWriter &) = delete;
+        DatasetWriter & operator= (const DatasetWriter &) = delete;
+
+        std::size_t rowCount() const noexcept
+        {
+            return m_header.rowCount;
+        }
+
+        // Throws std::invalid_argument if the situation does not fit the dataset
+        void write(const std::vector<bool> & situation, int64_t label)
+        {
+            if (m_header.kind != static_cast<uint32_t>(DatasetKind::Bits) || situation.size() != m_header.situationLength)
+            {
+                throw std::invalid_argument("Situation does not fit the dataset");
+            }
+
+            m_words.assign(Bits::wordCount(situation.size()), 0);
+            for (std::size_t i = 0; i < situation.size(); ++i)
+            {
+                if (situation[i])
+                {
+                    m_words[i / Bits::wordBitLength] |= uint64_t(1) << (i % Bits::wordBitLength);
+                }
+            }
+            m_writer.writeBytes(m_words.data(), m_words.size() * sizeof(uint64_t));
+            writeLabel(label);
+        }
+
+        void write(const std::vector<double> & situation, int64_t label)
+        {
+            if (m_header.kind != static_cast<uint32_t>(DatasetKind::Reals) || situation.size() != m_header.situationLength)
+            {
+                throw std::invalid_argument("Situation does not fit the dataset");
+            }
+
+            m_writer.writeBytes(situation.data(), situation.size() * sizeof(double));
+            writeLabel(label);
+        }
+
+        // Writes the labels and the header (throws std::runtime_error on a write error)
+        void close()
+        {
+            if (m_isClosed)
+            {
+                return;
+            }
+            m_isClosed = true;
+
+            m_header.labelOffset = m_header.rowOffset + m_header.rowCount * m_header.rowStride;
+            m_header.labelCount = m_labels.size();
+            for (auto && label : m_labels)
+            {
+                m_writer.write(label);
+            }
+            m_writer.flush();
+
+            std::memcpy(m_header.magic, DatasetHeader::magicString(), sizeof(m_header.magic));
+            m_file.seekp(0);
+            m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+            m_file.close();
+            if (!m_file)
+            {
+                throw std::runtime_error("Cannot write " + m_filename);
+            }
+        }
+    };
+
+    // Read-only dataset file mapped into memory
+    //   Rows are read in place from the mapping (row() returns a pointer into it), so
+    //   a dataset larger than the memory is paged in as it is used, and processes
+    //   training on the same file share its pages.
+    class Dataset
+    {
+    private:
+        MappedFile m_file;
+        const DatasetHeader * m_header;
+        std::vector<int64_t> m_labels;
+
+    public:
+        // Constructor
+        //   Throws std::runtime_error if the file is not a valid dataset
+        explicit Dataset(const std::string & filename) : m_file(filename)
+        {
+            auto error = [&filename](const std::string & message) {
+                return std::runtime_error(filename + ": " + message);
+            };
+
+            if (m_file.size() < sizeof(DatasetHeader))
+            {
+                throw error("Not a dataset");
+            }
+
+            m_header = reinterpret_cast<const DatasetHeader *>(m_file.data());
+            if (std::memcmp(m_header->magic, DatasetHeader::magicString(), sizeof(m_header->magic)) != 0)
+            {
+                throw error("Not a dataset");
+            }
+            if (m_header->version != DatasetHeader::currentVersion)
+            {
+                throw error("Unsupported dataset version " + std::to_string(m_header->version));
+            }
+            if (m_header->kind != static_cast<uint32_t>(DatasetKind::Bits) && m_header->kind != static_cast<uint32_t>(DatasetKind::Reals))
+            {
+                throw error("Unknown dataset kind");
+            }
+            if (m_header->situationLength > m_file.size() || m_header->rowStride != DatasetHeader::situationSize(kind(), m_header->situationLength) + sizeof(int64_t))
+            {
+                throw error("Invalid row size");
+            }
+
+            // Check the section bounds without overflowing
+            if (m_header->rowOffset < sizeof(DatasetHeader) || m_header->rowOffset % sizeof(uint64_t) != 0 || m_header->rowOffset > m_file.size()
+                || m_header->rowCount > (m_file.size() - m_header->rowOffset) / m_header->rowStride
+                || m_header->labelOffset != m_header->rowOffset + m_header->rowCount * m_header->rowStride
+                || m_header->labelCount > (m_file.size() - m_header->labelOffset) / sizeof(int64_t))
+            {
+                throw error("Truncated dataset");
+            }
+
+            m_labels.resize(m_header->labelCount);
+            std::memcpy(m_labels.data(), m_file.data() + m_header->labelOffset, m_labels.size() * sizeof(int64_t));
+        }
+
+        DatasetKind kind() const noexcept
+        {
+            return static_cast<DatasetKind>(m_header->kind);
+        }
+
+        std::size_t situationLength() const noexcept
+        {
+            return m_header->situationLength;
+        }
+
+        std::size_t rowCount() const noexcept
+        {
+            return m_header->rowCount;
+        }
+
+        // The distinct labels in increasing order
+        const std::vector<int64_t> & labels() const noexcept
+        {
+            return m_labels;
+        }
+
+        // The situation of row rowIdx in its stored form (8-byte aligned, see DatasetKind)
+        const unsigned char * row(std::size_t rowIdx) const
+        {
+            assert(rowIdx < m_header->rowCount);
+            return m_file.data() + m_header->rowOffset + rowIdx * m_header->rowStride;
+        }
+
+        int64_t label(std::size_t rowIdx) const
+        {
+            int64_t label;
+            std::memcpy(&label, row(rowIdx) + m_header->rowStride - sizeof(int64_t), sizeof(label));
+            return label;
+        }
+
+        // Unpacks the situation of row rowIdx into situation (whose capacity is reused)
+        template <typename T>
+        void situation(std::size_t rowIdx, std::vector<T> & situation) const
+        {
+            std::size_t length = m_header->situationLength;
+            situation.resize(length);
+
+            if (kind() == DatasetKind::Bits)
+            {
+                auto words = reinterpret_cast<const uint64_t *>(row(rowIdx));
+                for (std::size_t i = 0; i < length; ++i)
+                {
+                    situation[i] = static_cast<T>((words[i / Bits::wordBitLength] >> (i % Bits::wordBitLength)) & 1);
+                }
+            }
+            else
+            {
+                auto values = reinterpret_cast<const double *>(row(rowIdx));
+                for (std::size_t i = 0; i < length; ++i)
+                {
+                    situation[i] = static_cast<T>(values[i]);
+                }
+            }
+        }
+
+        template <typename T>
+        std::vector<T> situation(std::size_t rowIdx) const
+        {
+            std::vector<T> situation;
+            this->situation(rowIdx, situation);
+            return situation;
+        }
+
+        void advise(MappedFile::AccessPattern pattern) const noexcept
+        {
+            m_file.advise(pattern);
+        }
+
+        // Starts reading the rows [firstRowIdx, firstRowIdx + rowCount) in the background
+        void prefetch(std::size_t firstRowIdx, std::size_t rowCount) const noexcept
+        {
+            m_file.prefetch(m_header->rowOffset + firstRowIdx * m_header->rowStride, rowCount * m_header->rowStride);
+        }
+    };
+
+    // Parser of CSV records "x1,x2,...,xL,label"
+    //   Parses the line in place with strtod() and strtoll() (spaces around values are
+    //   allowed) and reuses its value buffer, so parsing does not allocate once the
+    //   buffer has grown to the record length.
+    class CsvRecordParser
+    {
+    private:
+        std::vector<double> m_values;
+        int64_t m_label;
+        std::size_t m_fieldCount;
+        std::size_t m_numericFieldCount;
+
+    public:
+        // Constructor
+        CsvRecordParser() : m_label(0), m_fieldCount(0), m_numericFieldCount(0) {}
+
+        // Returns true if the line is a record (two or more fields, all numbers, the
+        // last an integer)
+        bool parse(const std::string & line)
+        {
+            m_values.clear();
+            m_label = 0;
+            m_fieldCount = 0;
+            m_numericFieldCount = 0;
+
+            const char * fieldBegin = line.c_str();
+            const char * lineEnd = fieldBegin + line.size();
+            for (;;)
+            {
+                auto fieldEnd = static_cast<const char *>(std::memchr(fieldBegin, ',', lineEnd - fieldBegin));
+                bool isLastField = (fieldEnd == nullptr);
+                if (isLastField)
+                {
+                    fieldEnd = lineEnd;
+                }
+
+                char * end = nullptr;
+                errno = 0;
+                if (isLastField)
+                {
+                    m_label = std::strtoll(fieldBegin, &end, 10);
+                }
+                else
+                {
+                    m_values.push_back(std::strtod(fieldBegin, &end));
+                }
+                bool isNumber = (end != fieldBegin && errno == 0);
+                while (end < fieldEnd && std::isspace(static_cast<unsigned char>(*end)))
+                {
+                    ++end;
+                }
+
+                ++m_fieldCount;
+                if (isNumber && end == fieldEnd)
+                {
+                    ++m_numericFieldCount;
+                }
+
+                if (isLastField)
+                {
+                    break;
+                }
+                fieldBegin = fieldEnd + 1;
+            }
+
+            return m_fieldCount >= 2 && m_numericFieldCount == m_fieldCount;
+        }
+
+        // The values before the label
+        const std::vector<double> & values() const noexcept
+        {
+            return m_values;
+        }
+
+        int64_t label() const noexcept
+        {
+            return m_label;
+        }
+
+        std::size_t numericFieldCount() const noexcept
+        {
+            return m_numericFieldCount;
+        }
+    };
+
+    // Converts CSV lines "x1,x2,...,xL,label" into a dataset file and returns the row count
+    //   The last column is the integer label and the others are the situation (0 or 1
+    //   for DatasetKind::Bits). The situation length is taken from the first row. A
+    //   first line without numbers is taken as a header and skipped, as are empty
+    //   lines. Throws std::runtime_error (with the line number) on a malformed row.
+    inline std::size_t convertCsvToDataset(std::istream & csv, const std::string & filename, DatasetKind kind)
+    {
+        std::unique_ptr<DatasetWriter> writer;
+        std::size_t situationLength = 0;
+        CsvRecordParser parser;
+        std::vector<bool> bits;
+
+        std::string line;
+        for (std::size_t lineNumber = 1; std::getline(csv, line); ++lineNumber)
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") == std::string::npos)
+            {
+                continue;
+            }
+
+            auto error = [lineNumber](const std::string & message) {
+                return std::runtime_error("Line " + std::to_string(lineNumber) + ": " + message);
+            };
+
+            if (!parser.parse(line))
+            {
+                if (parser.numericFieldCount() == 0 && lineNumber == 1)
+                {
+                    continue;
+                }
+                throw error("Expected numeric values followed by an integer label");
+            }
+
+            auto && reals = parser.values();
+            if (!writer)
+            {
+                situationLength = reals.size();
+                writer.reset(new DatasetWriter(filename, kind, situationLength));
+            }
+            else if (reals.size() != situationLength)
+            {
+                throw error("Expected " + std::to_string(situationLength) + " situation values");
+            }
+
+            if (kind == DatasetKind::Bits)
+            {
+                bits.resize(reals.size());
+                for (std::size_t i = 0; i < reals.size(); ++i)
+                {
+                    if (reals[i] != 0.0 && reals[i] != 1.0)
+                    {
+                        throw error("Expected 0 or 1 in column " + std::to_string(i + 1));
+                    }
+                    bits[i] = (reals[i] != 0.0);
+                }
+                writer->write(bits, parser.label());
+            }
+            else
+            {
+                writer->write(reals, parser.label());
+            }
+        }
+
+        if (!writer)
+        {
+            writer.reset(new DatasetWriter(filename, kind, 0));
+        }
+        writer->close();
+
+        return writer->rowCount();
+    }
+
+}
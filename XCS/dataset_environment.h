@@ -0,0 +1,285 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#include "environment.h"
+#include "dataset.h"
+#include "random.h"
+#include "binary_stream.h"
+
+namespace XCS
+{
+
+    // Single-step environment serving the rows of a dataset file (see Dataset)
+    //   The situation is a row of the dataset and the reward is correctReward if the
+    //   action equals the label of the row (incorrectReward otherwise). Rows are served
+    //   in epochs, in file order or in a new random order each epoch. The order of an
+    //   epoch is a function of shuffleSeed and the epoch number only (it does not draw
+    //   from the engine of the experiment), so environments constructed with the same
+    //   arguments serve the same rows, and skip() can jump to any later position. The
+    //   dataset stays in the file mapping: each step unpacks only the current row, and
+    //   the rows needed in the next prefetchRowCount steps are requested from the disk
+    //   ahead of time, so training on a dataset larger than the memory does not stall on
+    //   page faults (prefetchRowCount = 0 leaves read-ahead to the kernel). Clones share
+    //   the mapping.
+    template <typename T, typename Action, class Symbol>
+    class DatasetEnvironment final : public AbstractEnvironment<T, Action, Symbol>
+    {
+    private:
+        std::shared_ptr<const Dataset> m_dataset;
+        const bool m_isShuffled;
+        const std::size_t m_prefetchRowCount;
+        const double m_correctReward;
+        const double m_incorrectReward;
+        const uint64_t m_shuffleSeed;
+
+        // Row order of the current epoch (nullptr in file order; shared by clones)
+        std::shared_ptr<const std::vector<uint64_t>> m_order;
+
+        // Position in the current epoch
+        std::size_t m_position;
+        uint64_t m_epoch;
+
+        std::vector<T> m_situation;
+        Action m_answer;
+        bool m_isEndOfProblem;
+
+        // The labels as actions (throws std::invalid_argument if a label does not
+        // round-trip through Action, e.g. 2 for Action = bool)
+        static std::unordered_set<Action> labelActions(const Dataset & dataset)
+        {
+            std::unordered_set<Action> actions;
+            for (auto && label : dataset.labels())
+            {
+                Action action = static_cast<Action>(label);
+                if (static_cast<int64_t>(action) != label)
+                {
+                    throw std::invalid_argument("Label " + std::to_string(label) + " cannot be represented by the action type");
+                }
+                actions.insert(action);
+            }
+            return actions;
+        }
+
+        // Sets the row order of m_epoch
+        void loadOrder()
+        {
+            if (!m_isShuffled)
+            {
+                return;
+            }
+
+            auto order = std::make_shared<std::vector<uint64_t>>(m_dataset->rowCount());
+            std::iota(order->begin(), order->end(), uint64_t(0));
+
+            // Fisher-Yates with an engine of its own for each epoch
+            RandomEngine engine(RandomEngine(m_shuffleSeed)() ^ m_epoch);
+            for (std::size_t i = order->size(); i-- > 1;)
+            {
+                std::uniform_int_distribution<std::size_t> dist(0, i);
+                std::swap((*order)[i], (*order)[dist(engine)]);
+            }
+
+            m_order = order;
+        }
+
+        // Requests the rows at the positions [begin, end) of the current epoch
+        void prefetch(std::size_t begin, std::size_t end) const
+        {
+            end = std::min(end, m_dataset->rowCount());
+            if (begin >= end)
+            {
+                return;
+            }
+
+            if (m_order)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    m_dataset->prefetch((*m_order)[i], 1);
+                }
+            }
+            else
+            {
+                m_dataset->prefetch(begin, end - begin);
+            }
+        }
+
+        // Unpacks the row at the current position and prefetches in batches of
+        // m_prefetchRowCount rows, one batch ahead of the position
+        void loadRow()
+        {
+            std::size_t rowIdx = this->rowIdx();
+            m_dataset->situation(rowIdx, m_situation);
+            m_answer = static_cast<Action>(m_dataset->label(rowIdx));
+
+            if (m_prefetchRowCount > 0 && m_position % m_prefetchRowCount == 0)
+            {
+                std::size_t begin = (m_position == 0) ? 0 : m_position + m_prefetchRowCount;
+                prefetch(begin, m_position + m_prefetchRowCount * 2);
+            }
+        }
+
+    public:
+        // Constructor
+        //   Throws std::invalid_argument if the dataset is empty, its situations cannot
+        //   be represented by T (a DatasetKind::Reals dataset for T = bool), or one of
+        //   its labels cannot be represented by Action.
+        //   Pass a different shuffleSeed (e.g. the seed of the experiment) to each
+        //   repetition of an experiment for different row orders.
+        DatasetEnvironment(std::shared_ptr<const Dataset> dataset, bool isShuffled = true, std::size_t prefetchRowCount = 256, double correctReward = 1000.0, double incorrectReward = 0.0, uint64_t shuffleSeed = 0) :
+            AbstractEnvironment<T, Action, Symbol>(labelActions(*dataset)),
+            m_dataset(dataset),
+            m_isShuffled(isShuffled),
+            m_prefetchRowCount(prefetchRowCount),
+            m_correctReward(correctReward),
+            m_incorrectReward(incorrectReward),
+            m_shuffleSeed(shuffleSeed),
+            m_position(0),
+            m_epoch(0),
+            m_answer(),
+            m_isEndOfProblem(false)
+        {
+            if (m_dataset->rowCount() == 0)
+            {
+                throw std::invalid_argument("Empty dataset");
+            }
+            if (std::is_same<T, bool>::value && m_dataset->kind() != DatasetKind::Bits)
+            {
+                throw std::invalid_argument("Binary situations need a dataset of DatasetKind::Bits");
+            }
+
+            // Shuffled epochs read rows in no particular order, so kernel read-ahead
+            // would only load pages that are not needed yet
+            m_dataset->advise(m_isShuffled ? MappedFile::AccessPattern::Random : MappedFile::AccessPattern::Sequential);
+
+            loadOrder();
+            loadRow();
+        }
+
+        explicit DatasetEnvironment(const std::string & filename, bool isShuffled = true, std::size_t prefetchRowCount = 256, double correctReward = 1000.0, double incorrectReward = 0.0, uint64_t shuffleSeed = 0) :
+            DatasetEnvironment(std::make_shared<const Dataset>(filename), isShuffled, prefetchRowCount, correctReward, incorrectReward, shuffleSeed)
+        {
+        }
+
+        ~DatasetEnvironment() = default;
+
+        std::vector<T> situation() const override
+        {
+            return m_situation;
+        }
+
+        double executeAction(Action action) override
+        {
+            double reward = (action == m_answer) ? m_correctReward : m_incorrectReward;
+
+            // Next row
+            if (++m_position == m_dataset->rowCount())
+            {
+                m_position = 0;
+                ++m_epoch;
+                loadOrder();
+            }
+            loadRow();
+
+            // Single-step problem
+            m_isEndOfProblem = true;
+
+            return reward;
+        }
+
+        bool isEndOfProblem() const override
+        {
+            return m_isEndOfProblem;
+        }
+
+        std::shared_ptr<AbstractEnvironment<T, Action, Symbol>> clone() const override
+        {
+            return std::make_shared<DatasetEnvironment>(*this);
+        }
+
+        // Moves problemCount rows ahead (across epochs), as the clones of a parallel
+        // Experiment::evaluate() do to serve disjoint rows
+        void skip(std::size_t problemCount) override
+        {
+            std::size_t rowCount = m_dataset->rowCount();
+            uint64_t epoch = m_epoch + problemCount / rowCount + (m_position + problemCount % rowCount) / rowCount;
+            m_position = (m_position + problemCount % rowCount) % rowCount;
+            if (epoch != m_epoch)
+            {
+                m_epoch = epoch;
+                loadOrder();
+            }
+            loadRow();
+        }
+
+        // The order of the epoch is not written, as it follows from the seed
+        void writeState(BinaryWriter & writer) const override
+        {
+            writer.write<uint64_t>(m_position);
+            writer.write(m_epoch);
+            writer.write(m_isEndOfProblem);
+            writer.write<uint8_t>(m_isShuffled);
+            writer.write(m_shuffleSeed);
+        }
+
+        void readState(BinaryReader & reader) override
+        {
+            uint64_t position = reader.read<uint64_t>();
+            uint64_t epoch = reader.read<uint64_t>();
+            bool isEndOfProblem = reader.read<bool>();
+            bool isShuffled = (reader.read<uint8_t>() != 0);
+            uint64_t shuffleSeed = reader.read<uint64_t>();
+
+            if (position >= m_dataset->rowCount())
+            {
+                throw std::runtime_error("Invalid dataset environment state");
+            }
+            if (isShuffled != m_isShuffled || (m_isShuffled && shuffleSeed != m_shuffleSeed))
+            {
+                throw std::runtime_error("Checkpoint of a dataset environment with a different row order");
+            }
+
+            m_position = static_cast<std::size_t>(position);
+            m_epoch = epoch;
+            m_isEndOfProblem = isEndOfProblem;
+            loadOrder();
+            loadRow();
+        }
+
+        const Dataset & dataset() const noexcept
+        {
+            return *m_dataset;
+        }
+
+        // The number of completed passes over the dataset
+        uint64_t epoch() const noexcept
+        {
+            return m_epoch;
+        }
+
+        // The row of the current situation
+        std::size_t rowIdx() const
+        {
+            return m_order ? static_cast<std::size_t>((*m_order)[m_position]) : m_position;
+        }
+
+        // The label of the current situation (the action rewarded with correctReward)
+        Action answer() const noexcept
+        {
+            return m_answer;
+        }
+    };
+
+}
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <unordered_set>
+#include <stdexcept>
 #include <cstddef>
 #include <cassert>
 
 #include "random.h"
 #include "symbol.h"
+#include "binary_stream.h"
 
 namespace XCS
 {
@@ -40,6 +43,32 @@ namespace XCS
         // Returns true if the problem was solved by the previous action
         // (always true for a single-step problem after the first action execution)
         virtual bool isEndOfProblem() const = 0;
+
+        // Returns an independent copy of the environment in its current state (used to
+        // evaluate on several threads), or nullptr if the environment cannot be copied
+        virtual std::shared_ptr<AbstractEnvironment<T, Action, Symbol>> clone() const
+        {
+            return nullptr;
+        }
+
+        // Advances the environment by problemCount problems without running them
+        //   Called by Experiment::evaluate() on the clone of each block, so that an
+        //   environment serving a fixed sequence of problems gives the blocks disjoint
+        //   parts of it. Environments drawing problems at random keep the default, which
+        //   does nothing.
+        virtual void skip(std::size_t)
+        {
+        }
+
+        // Writes and reads the state that changes while the environment is used (saved
+        // with experiment checkpoints; environments without such state keep the defaults)
+        virtual void writeState(BinaryWriter &) const
+        {
+        }
+
+        virtual void readState(BinaryReader &)
+        {
+        }
     };
 
     class MultiplexerEnvironment final : public AbstractEnvironment<bool, bool, Symbol<bool>>
@@ -106,6 +135,28 @@ namespace XCS
             return m_isEndOfProblem;
         }
 
+        std::shared_ptr<AbstractEnvironment<bool, bool, Symbol<bool>>> clone() const override
+        {
+            return std::make_shared<MultiplexerEnvironment>(*this);
+        }
+
+        void writeState(BinaryWriter & writer) const override
+        {
+            writer.writeVector(m_situation);
+            writer.write(m_isEndOfProblem);
+        }
+
+        void readState(BinaryReader & reader) override
+        {
+            reader.readVector(m_situation);
+            reader.read(m_isEndOfProblem);
+
+            if (m_situation.size() != m_totalLength)
+            {
+                throw std::runtime_error("Invalid multiplexer state");
+            }
+        }
+
         // Returns answer to situation
         bool getAnswer(const std::vector<bool> & situation) const
         {
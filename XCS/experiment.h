@@ -1,9 +1,14 @@
 #pragma once
 
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 #include <memory>
 #include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstring>
 #include <cstdint>
 #include <cstddef>
 #include <cmath>
@@ -20,6 +25,9 @@
 #include "prediction_array.h"
 #include "environment.h"
 #include "random.h"
+#include "thread_pool.h"
+#include "binary_stream.h"
+#include "profiler.h"
 
 namespace XCS
 {
@@ -71,10 +79,80 @@ namespace XCS
 
         const Constants m_constants;
 
+        // The random number engine of this experiment (installed as the engine of the
+        // calling thread during run() and evaluate())
+        RandomEngine m_random;
+
         // Environment(s)
         std::shared_ptr<AbstractEnvironment<T, Action, Symbol>> m_environment;
         std::shared_ptr<AbstractEnvironment<T, Action, Symbol>> m_evaluationEnvironment;
 
+        // Threads for evaluate() (nullptr evaluates on the calling thread)
+        std::shared_ptr<ThreadPool> m_evaluationThreadPool;
+
+        // Phase times and event counts of run() (collected if XCS_PROFILING is defined)
+        Profiler m_profiler;
+
+        // Runs the evaluation loop on the given environment and returns the reward sum
+        //   Only reads the population, so it may run on several threads at once (each with
+        //   its own environment).
+        double evaluateOn(AbstractEnvironment<T, Action, Symbol> & environment, std::size_t loopCount) const
+        {
+            MatchSet matchSet(m_constants, environment.availableActions);
+
+            double rewardSum = 0.0;
+            for (std::size_t i = 0; i < loopCount; ++i)
+            {
+                auto situation = environment.situation();
+
+                matchSet.regenerateActionSums(m_population, situation);
+
+                Action action;
+                if (matchSet.coveredActionCount() > 0)
+                {
+                    auto predictionArray = GreedyPredictionArray<T, Action, Symbol, Condition, Classifier, MatchSet>(matchSet);
+                    action = predictionArray.selectAction();
+                }
+                else
+                {
+                    action = Random::chooseFrom(matchSet.actionIndex().actions());
+                }
+
+                rewardSum += environment.executeAction(action);
+            }
+
+            return rewardSum;
+        }
+
+        // Checkpoint header: magic, format version, sizes of the situation and action
+        // types, and the time stamp
+        void writeCheckpointHeader(BinaryWriter & writer) const
+        {
+            writer.writeBytes("XCSCKPT", 8);
+            writer.write<uint32_t>(1);
+            writer.write<uint32_t>(sizeof(T));
+            writer.write<uint32_t>(sizeof(Action));
+            writer.write(m_timeStamp);
+        }
+
+        // Reads the header and the population of a checkpoint
+        void readCheckpointPopulation(BinaryReader & reader)
+        {
+            char magic[8];
+            reader.readBytes(magic, sizeof(magic));
+            uint32_t version = reader.read<uint32_t>();
+            uint32_t situationSymbolSize = reader.read<uint32_t>();
+            uint32_t actionSize = reader.read<uint32_t>();
+            if (std::memcmp(magic, "XCSCKPT", 8) != 0 || version != 1 || situationSymbolSize != sizeof(T) || actionSize != sizeof(Action))
+            {
+                throw std::runtime_error("Not a checkpoint of this experiment type");
+            }
+
+            uint64_t timeStamp = reader.read<uint64_t>();
+            m_population.read(reader);
+            m_timeStamp = timeStamp;
+        }
+
     public:
         // Constructor
         Experiment(std::shared_ptr<AbstractEnvironment<T, Action, Symbol>> environment, const Constants & constants) :
@@ -85,6 +163,7 @@ namespace XCS
             m_timeStamp(0),
             m_prevReward(0.0),
             m_constants(constants),
+            m_random(Random::nondeterministicSeed()),
             m_environment(environment),
             m_evaluationEnvironment(environment)
         {
@@ -99,6 +178,7 @@ namespace XCS
             m_actionSet(constants, environment->availableActions),
             m_prevActionSet(constants, environment->availableActions),
             m_constants(constants),
+            m_random(Random::nondeterministicSeed()),
             m_timeStamp(0),
             m_prevReward(0.0)
         {
@@ -108,27 +188,63 @@ namespace XCS
         // Destructor
         virtual ~Experiment() = default;
 
+        // Restarts the random number sequence of the experiment from the given seed
+        void seed(uint64_t seed)
+        {
+            m_random.seed(seed);
+        }
+
+        RandomEngine & randomEngine() noexcept
+        {
+            return m_random;
+        }
+
+        const RandomEngine & randomEngine() const noexcept
+        {
+            return m_random;
+        }
+
         // RUN EXPERIMENT
         virtual void run(std::size_t loopCount)
         {
+            Random::Scope randomScope(m_random);
+            XCS_PROFILE_SCOPE(m_profiler);
+
             // Main loop
             for (std::size_t i = 0; i < loopCount; ++i)
             {
-                auto situation = m_environment->situation();
+                XCS_PROFILE_STEP();
+
+                std::vector<T> situation;
+                {
+                    XCS_PROFILE_PHASE(Environment);
+                    situation = m_environment->situation();
+                }
 
                 m_matchSet.regenerate(m_population, situation, m_timeStamp);
 
-                PredictionArray predictionArray(m_matchSet, m_constants.exploreProbability);
+                Action action;
+                double maxPrediction;
+                {
+                    XCS_PROFILE_PHASE(PredictionArray);
+
+                    PredictionArray predictionArray(m_matchSet, m_constants.exploreProbability);
 
-                Action action = predictionArray.selectAction();
+                    action = predictionArray.selectAction();
+                    maxPrediction = predictionArray.max();
 
-                m_actionSet.regenerate(m_matchSet, action);
+                    m_actionSet.regenerate(m_matchSet, action);
+                }
 
-                double reward = m_environment->executeAction(action);
+                double reward;
+                {
+                    XCS_PROFILE_PHASE(Environment);
+                    reward = m_environment->executeAction(action);
+                }
 
                 if (!m_prevActionSet.empty())
                 {
-                    double p = m_prevReward + m_constants.gamma * predictionArray.max();
+                    double p = m_prevReward + m_constants.gamma * maxPrediction;
                     m_prevActionSet.update(p, m_population);
                     m_prevActionSet.runGA(m_prevSituation, m_population, m_timeStamp);
                 }
@@ -141,7 +257,7 @@ namespace XCS
                 }
                 else
                 {
-                    m_actionSet.copyTo(m_prevActionSet);
+                    m_actionSet.moveTo(m_prevActionSet);
                     m_prevReward = reward;
                     m_prevSituation = situation;
                 }
@@ -150,37 +266,295 @@ namespace XCS
         }
 
         // Runs experiment without exploration and returns reward average
-        virtual double evaluate(std::size_t loopCount) const
+        //   Uses the evaluation environment. With an evaluation thread pool (see
+        //   setEvaluationThreadCount()) and an environment supporting clone(), the loop
+        //   is split into one block per thread. Each block runs on its own clone with its
+        //   own random number stream split from the experiment's engine, and the block
+        //   sums are added in block order, so the result depends only on the seed and the
+        //   thread count (not on scheduling). Each clone is moved to the start of its
+        //   block with skip(), so an environment with a fixed sequence of problems (such
+        //   as DatasetEnvironment) is evaluated on the same loopCount consecutive
+        //   problems as on one thread, each once, and the evaluation environment is then
+        //   advanced past them with skip() as if it had run the loop itself. Draws from
+        //   the experiment's engine, so it must not be called on the same experiment from
+        //   several threads at once.
+        virtual double evaluate(std::size_t loopCount)
         {
-            double rewardSum = 0.0;
-            for (std::size_t i = 0; i < loopCount; ++i)
-            {
-                auto situation = m_evaluationEnvironment->situation();
+            std::size_t blockCount = m_evaluationThreadPool ? std::min(m_evaluationThreadPool->threadCount(), loopCount) : 1;
 
-                MatchSet matchSet(m_constants, m_environment->availableActions);
-                for (auto && cl : m_population)
+            std::vector<std::shared_ptr<AbstractEnvironment<T, Action, Symbol>>> environments;
+            if (blockCount > 1)
+            {
+                for (std::size_t i = 0; i < blockCount; ++i)
                 {
-                    if (cl->condition.matches(situation))
+                    auto environment = m_evaluationEnvironment->clone();
+                    if (!environment)
                     {
-                        matchSet.insert(cl);
+                        break;
                     }
+                    environments.push_back(environment);
                 }
-                
-                Action action;
-                if (!matchSet.empty())
+            }
+
+            if (environments.size() < 2)
+            {
+                Random::Scope randomScope(m_random);
+                return evaluateOn(*m_evaluationEnvironment, loopCount) / loopCount;
+            }
+
+            std::vector<RandomEngine> randomEngines;
+            for (std::size_t i = 0; i < blockCount; ++i)
+            {
+                randomEngines.push_back(m_random.split());
+            }
+
+            std::vector<double> rewardSums(blockCount, 0.0);
+            m_evaluationThreadPool->parallelFor(blockCount, [&](std::size_t i) {
+                Random::Scope randomScope(randomEngines[i]);
+                std::size_t blockBegin = loopCount / blockCount * i + std::min(i, loopCount % blockCount);
+                std::size_t blockLoopCount = loopCount / blockCount + ((i < loopCount % blockCount) ? 1 : 0);
+                environments[i]->skip(blockBegin);
+                rewardSums[i] = evaluateOn(*environments[i], blockLoopCount);
+            });
+            m_evaluationEnvironment->skip(loopCount);
+
+            double rewardSum = 0.0;
+            for (auto && blockRewardSum : rewardSums)
+            {
+                rewardSum += blockRewardSum;
+            }
+
+            return rewardSum / loopCount;
+        }
+
+        // Sets the number of threads used by evaluate() (1 evaluates on the calling thread,
+        // 0 uses the number of hardware threads)
+        void setEvaluationThreadCount(std::size_t threadCount)
+        {
+            if (threadCount == 1)
+            {
+                m_evaluationThreadPool.reset();
+            }
+            else
+            {
+                m_evaluationThreadPool = std::make_shared<ThreadPool>(threadCount);
+            }
+        }
+
+        // Writes the state of the experiment (see loadCheckpoint())
+        //   In order: header and time stamp, [P] with the bookkeeping of the deletion
+        //   votes, the previous reward and situation, [A]_-1 (as positions in [P], with
+        //   the classifiers deleted from [P] since written in full), the random number
+        //   engine, and the environment states. The constants are not written; a
+        //   checkpoint is loaded into an experiment constructed with the same constants
+        //   and environments. Throws std::runtime_error if the stream fails.
+        void saveCheckpoint(std::ostream & os) const
+        {
+            BinaryWriter writer(os);
+
+            writeCheckpointHeader(writer);
+            m_population.write(writer);
+
+            writer.write(m_prevReward);
+            writer.writeVector(m_prevSituation);
+
+            std::unordered_map<const Classifier *, std::size_t> positions;
+            for (auto && cl : m_population)
+            {
+                positions.emplace(cl.get(), positions.size());
+            }
+
+            writer.write<uint64_t>(m_prevActionSet.size());
+            for (auto && cl : m_prevActionSet)
+            {
+                auto it = positions.find(cl.get());
+                if (it != positions.end())
                 {
-                    auto predictionArray = GreedyPredictionArray<T, Action, Symbol, Condition, Classifier, MatchSet>(matchSet);
-                    action = predictionArray.selectAction();
+                    writer.write<uint8_t>(1);
+                    writer.write<uint64_t>(it->second);
                 }
                 else
                 {
-                    action = Random::chooseFrom(m_environment->availableActions);
+                    writer.write<uint8_t>(0);
+                    cl->write(writer);
                 }
+            }
 
-                rewardSum += m_environment->executeAction(action);
+            writer.write(m_random);
+
+            m_environment->writeState(writer);
+            writer.write<uint8_t>(m_evaluationEnvironment != m_environment);
+            if (m_evaluationEnvironment != m_environment)
+            {
+                m_evaluationEnvironment->writeState(writer);
             }
 
-            return rewardSum / loopCount;
+            writer.flush();
+        }
+
+        void saveCheckpoint(const std::string & filename) const
+        {
+            std::ofstream file(filename, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            saveCheckpoint(file);
+        }
+
+        // Restores the state written by saveCheckpoint()
+        //   run() then continues exactly as the saved experiment would have (same
+        //   random numbers, deletions and GA invocations), provided that the population
+        //   visits matching classifiers in insertion order, as Population does. Throws
+        //   std::runtime_error on a malformed checkpoint, leaving the experiment in a
+        //   valid but unspecified state.
+        void loadCheckpoint(std::istream & is)
+        {
+            BinaryReader reader(is);
+
+            m_prevActionSet.clear();
+            readCheckpointPopulation(reader);
+
+            reader.read(m_prevReward);
+            reader.readVector(m_prevSituation);
+
+            std::size_t prevActionSetSize = reader.readLength(sizeof(uint8_t) + sizeof(uint64_t));
+            for (std::size_t i = 0; i < prevActionSetSize; ++i)
+            {
+                if (reader.read<uint8_t>() != 0)
+                {
+                    std::size_t position = static_cast<std::size_t>(reader.read<uint64_t>());
+                    if (position >= m_population.size())
+                    {
+                        throw std::runtime_error("Invalid checkpoint");
+                    }
+                    m_prevActionSet.insert(*(m_population.begin() + position));
+                }
+                else
+                {
+                    m_prevActionSet.insert(m_population.readClassifier(reader));
+                }
+            }
+
+            reader.read(m_random);
+
+            m_environment->readState(reader);
+            if ((reader.read<uint8_t>() != 0) != (m_evaluationEnvironment != m_environment))
+            {
+                throw std::runtime_error("Checkpoint of an experiment with different environments");
+            }
+            if (m_evaluationEnvironment != m_environment)
+            {
+                m_evaluationEnvironment->readState(reader);
+            }
+        }
+
+        void loadCheckpoint(const std::string & filename)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            loadCheckpoint(file);
+        }
+
+        // Replaces the population (and the time stamp) with the one of a checkpoint
+        //   Warm start from an earlier run: the random number engine and the
+        //   environments of this experiment are kept, and learning continues with a new
+        //   problem.
+        void loadPopulation(std::istream & is)
+        {
+            BinaryReader reader(is);
+
+            m_prevActionSet.clear();
+            readCheckpointPopulation(reader);
+        }
+
+        void loadPopulation(const std::string & filename)
+        {
+            std::ifstream file(filename, std::ios::binary);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            loadPopulation(file);
+        }
+
+        const Population & population() const noexcept
+        {
+            return m_population;
+        }
+
+        // The phase times, event counts and step latencies of run()
+        //   Empty unless compiled with XCS_PROFILING defined. Call checkpoint() on it to
+        //   close an interval, e.g. along with saveCheckpoint().
+        Profiler & profiler() noexcept
+        {
+            return m_profiler;
+        }
+
+        const Profiler & profiler() const noexcept
+        {
+            return m_profiler;
+        }
+
+        // The numbering of the actions used by the prediction arrays of predict()
+        const ActionIndex<Action> & actionIndex() const noexcept
+        {
+            return m_population.actionIndex();
+        }
+
+        // Returns the action with the highest prediction for each situation
+        //   The batch version of the action selection in evaluate(). Ties, and situations
+        //   matched by no classifier, are resolved at random with random (e.g. an engine
+        //   split off randomEngine()), so the result depends only on the population and
+        //   the state of random. predict() leaves the experiment untouched and may be
+        //   called from several threads at once, each with its own engine.
+        std::vector<Action> predict(const std::vector<std::vector<T>> & situations, RandomEngine & random) const
+        {
+            std::vector<double> predictionArrays;
+            return predict(situations, predictionArrays, random);
+        }
+
+        // Also returns the prediction arrays in predictionArrays[situationIdx * actionCount
+        // + actionIdx], where actionIdx is actionIndex().idx(action) (NaN for actions not
+        // advocated by any matching classifier)
+        //   The per-action sums of all situations are accumulated in one pass over the
+        //   (classifier, situation) pairs of Population::forEachMatchingPair(), without
+        //   forming a match set per situation.
+        std::vector<Action> predict(const std::vector<std::vector<T>> & situations, std::vector<double> & predictionArrays, RandomEngine & random) const
+        {
+            auto && actionIndex = m_population.actionIndex();
+            std::size_t actionCount = actionIndex.size();
+
+            // Per-action sums by [situationIdx * actionCount + actionIdx]
+            std::vector<PredictionArraySums> actionSums(situations.size() * actionCount, PredictionArraySums{ 0.0, 0.0, false });
+
+            // The calls for one classifier are consecutive, so its terms are computed once
+            const Classifier * prevCl = nullptr;
+            std::size_t actionIdx = 0;
+            double predictionTerm = 0.0;
+            double fitness = 0.0;
+            m_population.forEachMatchingPair(situations, [&](const ClassifierPtr & cl, std::size_t situationIdx) {
+                if (cl.get() != prevCl)
+                {
+                    prevCl = cl.get();
+                    actionIdx = actionIndex.idx(cl->action);
+                    predictionTerm = cl->prediction * cl->fitness;
+                    fitness = cl->fitness;
+                }
+
+                auto && sums = actionSums[situationIdx * actionCount + actionIdx];
+                sums.predictionSum += predictionTerm;
+                sums.fitnessSum += fitness;
+                sums.isCovered = true;
+            });
+
+            return selectGreedyActions(actionIndex.actions(), actionSums, predictionArrays, random);
         }
 
         virtual void dumpPopulation() const
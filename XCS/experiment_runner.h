@@ -0,0 +1,217 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <ostream>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "random.h"
+#include "thread_pool.h"
+
+namespace XCS
+{
+
+    // The loop of one repetition: checkpointCount times run(explorationLoopCount)
+    // followed by evaluate(evaluationLoopCount)
+    struct ExperimentSchedule
+    {
+        std::size_t checkpointCount = 500;
+        std::size_t explorationLoopCount = 100;
+        std::size_t evaluationLoopCount = 1000;
+    };
+
+    struct LearningCurvePoint
+    {
+        // The number of repetitions that have reached the checkpoint
+        std::size_t sampleCount;
+
+        double mean;
+
+        // Sample standard deviation (0 with fewer than two samples)
+        double standardDeviation;
+    };
+
+    // Evaluation results of several repetitions by checkpoint
+    //   record() stores into a preallocated slot owned by one (repetition, checkpoint)
+    //   pair, so writers never wait for each other or for readers. learningCurve() may
+    //   be called at any time (e.g. from a progress thread) and summarizes the results
+    //   recorded so far in repetition order, so the final curve does not depend on the
+    //   order in which the repetitions finished.
+    class LearningCurveCollector
+    {
+    private:
+        const std::size_t m_repetitionCount;
+        const std::size_t m_checkpointCount;
+
+        // Results by [repetitionIdx * m_checkpointCount + checkpointIdx] (NaN until recorded)
+        std::unique_ptr<std::atomic<double>[]> m_results;
+
+        // The number of results recorded by checkpoint
+        std::unique_ptr<std::atomic<std::size_t>[]> m_recordedCounts;
+
+    public:
+        // Constructor
+        LearningCurveCollector(std::size_t repetitionCount, std::size_t checkpointCount) :
+            m_repetitionCount(repetitionCount),
+            m_checkpointCount(checkpointCount),
+            m_results(new std::atomic<double>[repetitionCount * checkpointCount]),
+            m_recordedCounts(new std::atomic<std::size_t>[checkpointCount])
+        {
+            for (std::size_t i = 0; i < repetitionCount * checkpointCount; ++i)
+            {
+                m_results[i].store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+            }
+
+            for (std::size_t i = 0; i < checkpointCount; ++i)
+            {
+                m_recordedCounts[i].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        std::size_t repetitionCount() const noexcept
+        {
+            return m_repetitionCount;
+        }
+
+        std::size_t checkpointCount() const noexcept
+        {
+            return m_checkpointCount;
+        }
+
+        // Stores the evaluation result of a repetition at a checkpoint (once per pair)
+        void record(std::size_t repetitionIdx, std::size_t checkpointIdx, double result)
+        {
+            assert(repetitionIdx < m_repetitionCount && checkpointIdx < m_checkpointCount);
+            assert(std::isnan(m_results[repetitionIdx * m_checkpointCount + checkpointIdx].load(std::memory_order_relaxed)));
+
+            m_results[repetitionIdx * m_checkpointCount + checkpointIdx].store(result, std::memory_order_release);
+            m_recordedCounts[checkpointIdx].fetch_add(1, std::memory_order_release);
+        }
+
+        std::size_t recordedCount(std::size_t checkpointIdx) const
+        {
+            return m_recordedCounts[checkpointIdx].load(std::memory_order_acquire);
+        }
+
+        // Returns NaN if the result has not been recorded yet
+        double result(std::size_t repetitionIdx, std::size_t checkpointIdx) const
+        {
+            return m_results[repetitionIdx * m_checkpointCount + checkpointIdx].load(std::memory_order_acquire);
+        }
+
+        // Mean and standard deviation over the repetitions by checkpoint (Welford's method)
+        std::vector<LearningCurvePoint> learningCurve() const
+        {
+            return learningCurve(0, m_repetitionCount);
+        }
+
+        // Mean and standard deviation over the repetitions [firstRepetitionIdx,
+        // firstRepetitionIdx + repetitionCount) by checkpoint
+        std::vector<LearningCurvePoint> learningCurve(std::size_t firstRepetitionIdx, std::size_t repetitionCount) const
+        {
+            assert(firstRepetitionIdx + repetitionCount <= m_repetitionCount);
+
+            std::vector<LearningCurvePoint> curve;
+            curve.reserve(m_checkpointCount);
+
+            for (std::size_t i = 0; i < m_checkpointCount; ++i)
+            {
+                std::size_t sampleCount = 0;
+                double mean = 0.0;
+                double squaredDeviationSum = 0.0;
+                for (std::size_t j = firstRepetitionIdx; j < firstRepetitionIdx + repetitionCount; ++j)
+                {
+                    double x = result(j, i);
+                    if (std::isnan(x))
+                    {
+                        continue;
+                    }
+
+                    ++sampleCount;
+                    double delta = x - mean;
+                    mean += delta / sampleCount;
+                    squaredDeviationSum += delta * (x - mean);
+                }
+
+                double standardDeviation = (sampleCount > 1) ? std::sqrt(squaredDeviationSum / (sampleCount - 1)) : 0.0;
+                curve.push_back({ sampleCount, mean, standardDeviation });
+            }
+
+            return curve;
+        }
+
+        // Writes "checkpoint mean standardDeviation" lines (tab-separated, checkpoints from 1)
+        void writeLearningCurve(std::ostream & os) const
+        {
+            auto curve = learningCurve();
+            for (std::size_t i = 0; i < curve.size(); ++i)
+            {
+                os << (i + 1) << '\t' << curve[i].mean << '\t' << curve[i].standardDeviation << std::endl;
+            }
+        }
+    };
+
+    // Runs independent repetitions of an experiment in one process
+    //   Each repetition is one task on a work-stealing ThreadPool, so repetitions of
+    //   uneven length are balanced across the threads, and the experiments share
+    //   nothing but the collector. Throughput scales with the number of cores as long
+    //   as the populations of the concurrently running experiments fit the caches.
+    class ExperimentRunner
+    {
+    private:
+        ThreadPool m_threadPool;
+
+    public:
+        // Constructor
+        //   threadCount = 0 uses the number of hardware threads
+        explicit ExperimentRunner(std::size_t threadCount = 0) : m_threadPool(threadCount) {}
+
+        std::size_t threadCount() const noexcept
+        {
+            return m_threadPool.threadCount();
+        }
+
+        // Runs one repetition per seed and records its evaluation results in collector
+        //   makeExperiment(repetitionIdx, seed) returns a pointer to a new experiment
+        //   (with its own environments). It is called under a Random::Scope seeded with
+        //   seed, and the experiment then continues that random number sequence, so each
+        //   repetition is reproducible from its seed regardless of the thread it runs on.
+        //   The experiments should evaluate on the calling thread (no
+        //   setEvaluationThreadCount()); the repetitions already occupy the threads.
+        template <class ExperimentFactory>
+        void run(ExperimentFactory makeExperiment, const std::vector<uint64_t> & seeds, const ExperimentSchedule & schedule, LearningCurveCollector & collector)
+        {
+            assert(collector.repetitionCount() == seeds.size());
+            assert(collector.checkpointCount() == schedule.checkpointCount);
+
+            m_threadPool.parallelFor(seeds.size(), [&](std::size_t repetitionIdx) {
+                RandomEngine random(seeds[repetitionIdx]);
+                auto experiment = [&]() {
+                    Random::Scope randomScope(random);
+                    return makeExperiment(repetitionIdx, seeds[repetitionIdx]);
+                }();
+                experiment->randomEngine() = random;
+
+                for (std::size_t i = 0; i < schedule.checkpointCount; ++i)
+                {
+                    experiment->run(schedule.explorationLoopCount);
+                    collector.record(repetitionIdx, i, experiment->evaluate(schedule.evaluationLoopCount));
+                }
+            });
+        }
+
+        template <class ExperimentFactory>
+        LearningCurveCollector run(ExperimentFactory makeExperiment, const std::vector<uint64_t> & seeds, const ExperimentSchedule & schedule)
+        {
+            LearningCurveCollector collector(seeds.size(), schedule.checkpointCount);
+            run(makeExperiment, seeds, schedule, collector);
+            return collector;
+        }
+    };
+
+}
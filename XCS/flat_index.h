@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace XCS
+{
+
+    // Open-addressing hash multimap from keys to indices (e.g. slots of a population)
+    //   The (key, index) pairs live in one array, probed linearly from the Fibonacci hash
+    //   of the key and removed by shifting the following pairs back, so inserting and
+    //   erasing never allocate once the table has grown to its peak size (it doubles
+    //   when it gets more than half full). Several indices may share a key.
+    template <typename Key, class Hash = std::hash<Key>>
+    class FlatIndex
+    {
+    public:
+        static constexpr std::size_t npos = ~std::size_t(0);
+
+    private:
+        struct Bucket
+        {
+            Key key;
+            std::size_t idx; // npos for an empty bucket
+        };
+
+        std::vector<Bucket> m_buckets;
+        std::size_t m_shift;
+        std::size_t m_size;
+
+        std::size_t home(const Key & key) const
+        {
+            return static_cast<std::size_t>((static_cast<uint64_t>(Hash()(key)) * 0x9e3779b97f4a7c15) >> m_shift);
+        }
+
+        std::size_t mask() const noexcept
+        {
+            return m_buckets.size() - 1;
+        }
+
+        void rehash(std::size_t bucketCount)
+        {
+            std::vector<Bucket> buckets(bucketCount, Bucket{ Key(), npos });
+            buckets.swap(m_buckets);
+
+            m_shift = 64;
+            while (bucketCount > 1)
+            {
+                bucketCount >>= 1;
+                --m_shift;
+            }
+
+            for (auto && bucket : buckets)
+            {
+                if (bucket.idx != npos)
+                {
+                    std::size_t i = home(bucket.key);
+                    while (m_buckets[i].idx != npos)
+                    {
+                        i = (i + 1) & mask();
+                    }
+                    m_buckets[i] = bucket;
+                }
+            }
+        }
+
+    public:
+        // Constructor
+        FlatIndex() : m_shift(64), m_size(0) {}
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        // Grows the table so that count pairs fit without rehashing
+        void reserve(std::size_t count)
+        {
+            std::size_t bucketCount = 16;
+            while (bucketCount < count * 2)
+            {
+                bucketCount *= 2;
+            }
+
+            if (bucketCount > m_buckets.size())
+            {
+                rehash(bucketCount);
+            }
+        }
+
+        void insert(const Key & key, std::size_t idx)
+        {
+            assert(idx != npos);
+
+            reserve(m_size + 1);
+
+            std::size_t i = home(key);
+            while (m_buckets[i].idx != npos)
+            {
+                i = (i + 1) & mask();
+            }
+            m_buckets[i] = Bucket{ key, idx };
+            ++m_size;
+        }
+
+        // Removes the pair (key, idx) and returns false if it is not in the index
+        bool erase(const Key & key, std::size_t idx)
+        {
+            if (m_size == 0)
+            {
+                return false;
+            }
+
+            std::size_t i = home(key);
+            while (m_buckets[i].idx != idx || !(m_buckets[i].key == key))
+            {
+                if (m_buckets[i].idx == npos)
+                {
+                    return false;
+                }
+                i = (i + 1) & mask();
+            }
+
+            // Shift back the following pairs that would no longer be reachable
+            for (std::size_t j = (i + 1) & mask(); m_buckets[j].idx != npos; j = (j + 1) & mask())
+            {
+                std::size_t k = home(m_buckets[j].key);
+                bool isReachable = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+                if (!isReachable)
+                {
+                    m_buckets[i] = m_buckets[j];
+                    i = j;
+                }
+            }
+            m_buckets[i].idx = npos;
+            --m_size;
+
+            return true;
+        }
+
+        // Returns the first index of key for which pred(idx) is true (or npos)
+        template <class Predicate>
+        std::size_t findIf(const Key & key, Predicate pred) const
+        {
+            if (m_size == 0)
+            {
+                return npos;
+            }
+
+            for (std::size_t i = home(key); m_buckets[i].idx != npos; i = (i + 1) & mask())
+            {
+                if (m_buckets[i].key == key && pred(m_buckets[i].idx))
+                {
+                    return m_buckets[i].idx;
+                }
+            }
+
+            return npos;
+        }
+
+        // Returns an index of key (or npos)
+        std::size_t find(const Key & key) const
+        {
+            return findIf(key, [](std::size_t) { return true; });
+        }
+
+        // Removes all pairs (keeps the table)
+        void clear()
+        {
+            for (auto && bucket : m_buckets)
+            {
+                bucket.idx = npos;
+            }
+            m_size = 0;
+        }
+    };
+
+}
@@ -5,6 +5,9 @@
 #include <cassert>
 #include <cstddef>
 
+#include "action_index.h"
+#include "profiler.h"
+
 namespace XCS
 {
 
@@ -16,6 +19,21 @@ namespace XCS
 
         const Constants m_constants;
         const std::unordered_set<Action> & m_availableActions;
+        const ActionIndex<Action> m_actionIndex;
+
+        // Returns a random available action other than the given one
+        Action chooseOtherAction(const Action & action) const
+        {
+            assert(m_actionIndex.size() >= 2);
+
+            std::size_t idx = Random::nextInt<std::size_t>(0, m_actionIndex.size() - 2);
+            if (idx >= m_actionIndex.idx(action))
+            {
+                ++idx;
+            }
+
+            return m_actionIndex.action(idx);
+        }
 
         // SELECT OFFSPRING
         virtual ClassifierPtr selectOffspring(const ClassifierPtrSet & actionSet) const
@@ -63,9 +81,10 @@ namespace XCS
                 std::swap(x, y);
             }
 
+            using std::swap;
             for (std::size_t i = x + 1; i < y; ++i)
             {
-                std::swap(cl1.condition[i], cl2.condition[i]);
+                swap(cl1.condition[i], cl2.condition[i]);
             }
         }
 
@@ -74,26 +93,20 @@ namespace XCS
         {
             assert(cl.condition.size() == situation.size());
 
-            for (std::size_t i = 0; i < cl.condition.size(); ++i)
-            {
-                if (Random::nextDouble() < m_constants.mutationProbability)
+            Random::forEachBernoulliSuccess(cl.condition.size(), m_constants.mutationProbability, [&](std::size_t i) {
+                if (cl.condition[i].isDontCare())
                 {
-                    if (cl.condition[i].isDontCare())
-                    {
-                        cl.condition[i] = situation.at(i);
-                    }
-                    else
-                    {
-                        cl.condition[i].generalize();
-                    }
+                    cl.condition[i] = situation.at(i);
                 }
-            }
+                else
+                {
+                    cl.condition[i].generalize();
+                }
+            });
 
             if ((Random::nextDouble() < m_constants.mutationProbability) && (m_availableActions.size() >= 2))
             {
-                std::unordered_set<Action> otherPossibleActions(m_availableActions);
-                otherPossibleActions.erase(cl.action);
-                cl.action = Random::chooseFrom(otherPossibleActions);
+                cl.action = chooseOtherAction(cl.action);
             }
         }
 
@@ -101,7 +114,8 @@ namespace XCS
         // Constructor
         GA(const Constants & constants, const std::unordered_set<Action> & availableActions) :
             m_constants(constants),
-            m_availableActions(availableActions)
+            m_availableActions(availableActions),
+            m_actionIndex(availableActions)
         {
         }
 
@@ -143,21 +157,26 @@ namespace XCS
             {
                 mutate(*child, situation);
 
+                const ClassifierPtr * subsumer = nullptr;
                 if (m_constants.doGASubsumption)
                 {
+                    XCS_PROFILE_PHASE(Subsumption);
                     if (parent1->subsumes(*child))
                     {
-                        ++parent1->numerosity;
+                        subsumer = &parent1;
                     }
                     else if (parent2->subsumes(*child))
                     {
-                        ++parent2->numerosity;
-                    }
-                    else
-                    {
-                        population.insertOrIncrementNumerosity(*child);
+                        subsumer = &parent2;
                     }
                 }
+
+                if (subsumer != nullptr)
+                {
+                    XCS_PROFILE_COUNT(Subsumption);
+                    ++(*subsumer)->numerosity;
+                    population.updateDeletionVote(*subsumer);
+                }
                 else
                 {
                     population.insertOrIncrementNumerosity(*child);
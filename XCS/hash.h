@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace XCS
+{
+
+    // Mixes a hash value into seed (as boost::hash_combine)
+    inline std::size_t hashCombine(std::size_t seed, std::size_t value)
+    {
+        return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    }
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <cstddef>
+
+#include "population.h"
+
+namespace XCS
+{
+
+    // Population keeping a match index consistent with its classifiers
+    //   MatchIndex must be constructible from the constants and provide insert(cl),
+    //   erase(cl), clear() and forEachMatchingClassifier(situation, f). The index is
+    //   updated on every insertion and removal (GA offspring, covering, deletion and
+    //   subsumption), and match sets are formed by querying it instead of scanning the
+    //   whole population.
+    template <typename T, typename Action, class Symbol, class Condition, class Classifier, class Constants, class ClassifierPtrSet, class MatchIndex>
+    class IndexedPopulation : public Population<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>
+    {
+    protected:
+        using ClassifierPtr = std::shared_ptr<Classifier>;
+
+        MatchIndex m_index;
+
+    public:
+        // Constructor
+        IndexedPopulation(const Constants & constants, const std::unordered_set<Action> availableActions) :
+            Population<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>(constants, availableActions),
+            m_index(constants)
+        {
+        }
+
+        // Destructor
+        virtual ~IndexedPopulation() = default;
+
+        virtual bool insert(const ClassifierPtr & cl) override
+        {
+            if (!Population<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>::insert(cl))
+            {
+                return false;
+            }
+
+            m_index.insert(cl);
+            return true;
+        }
+
+        virtual void erase(const ClassifierPtr & cl) override
+        {
+            m_index.erase(cl);
+            Population<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>::erase(cl);
+        }
+
+        virtual void clear() override
+        {
+            m_index.clear();
+            Population<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>::clear();
+        }
+
+        // Calls f for each classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            m_index.forEachMatchingClassifier(situation, f);
+        }
+
+        // Calls f(cl, situationIdx) for each pair of a classifier and a situation it matches
+        // (one index query per situation, which visits only candidate classifiers)
+        template <class Function>
+        void forEachMatchingPair(const std::vector<std::vector<T>> & situations, Function f) const
+        {
+            for (std::size_t i = 0; i < situations.size(); ++i)
+            {
+                m_index.forEachMatchingClassifier(situations[i], [&](const ClassifierPtr & cl) {
+                    f(cl, i);
+                });
+            }
+        }
+    };
+
+}
@@ -1,49 +1,61 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <cstddef>
 
 #include "condition.h"
 #include "classifier.h"
 #include "experiment.h"
+#include "packed_experiment.h"
+#include "experiment_runner.h"
+#include "multiplexer_sweep.h"
 
 using namespace XCS;
 
-int main()
+// The environment of the experiments
+std::shared_ptr<MultiplexerEnvironment> makeEnvironment(std::size_t multiplexerLength)
 {
-    std::size_t multiplexerLength = 11;
-
-    Constants constants;
+    return std::make_shared<MultiplexerEnvironment>(multiplexerLength);
+}
 
-    if (multiplexerLength == 3)
-    {
-        constants.maxPopulationClassifierCount = 200;
-    }
-    else if (multiplexerLength == 6)
-    {
-        constants.maxPopulationClassifierCount = 400;
-    }
-    else if (multiplexerLength == 11)
-    {
-        constants.maxPopulationClassifierCount = 800;
-    }
-    else if (multiplexerLength == 20)
-    {
-        constants.maxPopulationClassifierCount = 2000;
-        constants.generalizeProbability = 0.5;
-    }
-    else if (multiplexerLength == 37)
+// Usage: xcs [sweep config file]
+//   Without arguments, runs the experiment below (the learning curve of one run, or
+//   the average of repetitionCount runs); with a config file, runs a parameter sweep.
+int main(int argc, char * argv[])
+{
+    if (argc > 1)
     {
-        constants.maxPopulationClassifierCount = 5000;
-        constants.generalizeProbability = 0.65;
+        return runMultiplexerSweep<PackedExperiment<bool>>(argv[1], Constants(), 11, makeEnvironment);
     }
-    else
+
+    std::size_t multiplexerLength = 11;
+
+    // The number of independent runs averaged into one learning curve
+    std::size_t repetitionCount = 1;
+
+    Constants constants = multiplexerConstants(Constants(), multiplexerLength);
+
+    if (repetitionCount > 1)
     {
-        constants.maxPopulationClassifierCount = 50000;
-        constants.generalizeProbability = 0.75;
+        std::vector<uint64_t> seeds;
+        for (std::size_t i = 0; i < repetitionCount; ++i)
+        {
+            seeds.push_back(Random::nondeterministicSeed());
+        }
+
+        ExperimentRunner runner;
+        auto collector = runner.run([&](std::size_t, uint64_t) {
+            return std::make_unique<PackedExperiment<bool>>(makeEnvironment(multiplexerLength), constants);
+        }, seeds, ExperimentSchedule());
+        collector.writeLearningCurve(std::cout);
+
+        return 0;
     }
 
-    Experiment<bool, bool> xcs(std::make_shared<MultiplexerEnvironment>(multiplexerLength), constants);
+    PackedExperiment<bool> xcs(makeEnvironment(multiplexerLength), constants);
+    xcs.setEvaluationThreadCount(0);
     for (std::size_t i = 0; i < 500; ++i)
     {
         xcs.run(100);
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace XCS
+{
+
+    // Read-only view of a whole file
+    //   On POSIX systems the file is mapped with mmap(MAP_SHARED), so opening is O(1),
+    //   pages are loaded on first access, and processes mapping the same file share its
+    //   physical pages through the page cache. Elsewhere the file is read into memory.
+    //   The data is aligned to at least 8 bytes (page-aligned when mapped). Files larger
+    //   than the memory are paged in on demand; advise() and prefetch() help the kernel
+    //   read the pages ahead of their use.
+    class MappedFile
+    {
+    private:
+        const unsigned char * m_data;
+        std::size_t m_size;
+
+#if defined(_WIN32)
+        std::vector<unsigned long long> m_buffer; // 8-byte aligned storage
+#endif
+
+    public:
+        // Constructor
+        //   Throws std::runtime_error if the file cannot be opened or mapped
+        explicit MappedFile(const std::string & filename) : m_data(nullptr), m_size(0)
+        {
+#if defined(_WIN32)
+            std::ifstream file(filename, std::ios::binary | std::ios::ate);
+            if (!file)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            m_size = static_cast<std::size_t>(file.tellg());
+            m_buffer.resize((m_size + sizeof(unsigned long long) - 1) / sizeof(unsigned long long));
+            file.seekg(0);
+            if (!file.read(reinterpret_cast<char *>(m_buffer.data()), m_size))
+            {
+                throw std::runtime_error("Cannot read " + filename);
+            }
+            m_data = reinterpret_cast<const unsigned char *>(m_buffer.data());
+#else
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Cannot open " + filename);
+            }
+
+            struct stat status;
+            if (::fstat(fd, &status) != 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Cannot stat " + filename);
+            }
+            m_size = static_cast<std::size_t>(status.st_size);
+
+            if (m_size > 0)
+            {
+                void * data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot map " + filename);
+                }
+                m_data = static_cast<const unsigned char *>(data);
+            }
+
+            // The mapping stays valid after the descriptor is closed
+            ::close(fd);
+#endif
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator= (const MappedFile &) = delete;
+
+        // Destructor
+        ~MappedFile()
+        {
+#if !defined(_WIN32)
+            if (m_data != nullptr)
+            {
+                ::munmap(const_cast<unsigned char *>(m_data), m_size);
+            }
+#endif
+        }
+
+        const unsigned char * data() const noexcept
+        {
+            return m_data;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        enum class AccessPattern
+        {
+            Normal,
+            Sequential, // aggressive read-ahead, pages dropped soon after use
+            Random      // no read-ahead (use prefetch() for the pages needed next)
+        };
+
+        // Tells the kernel how the file will be accessed (no effect when not mapped)
+        void advise(AccessPattern pattern) const noexcept
+        {
+#if defined(_WIN32)
+            (void)pattern;
+#else
+            if (m_data != nullptr)
+            {
+                int advice = (pattern == AccessPattern::Sequential) ? MADV_SEQUENTIAL : (pattern == AccessPattern::Random) ? MADV_RANDOM : MADV_NORMAL;
+                ::madvise(const_cast<unsigned char *>(m_data), m_size, advice);
+            }
+#endif
+        }
+
+        // Starts reading the pages of [offset, offset + size) in the background, so that
+        // accessing them later does not wait for the disk (no effect when not mapped)
+        void prefetch(std::size_t offset, std::size_t size) const noexcept
+        {
+#if defined(_WIN32)
+            (void)offset;
+            (void)size;
+#else
+            if (m_data == nullptr || offset >= m_size || size == 0)
+            {
+                return;
+            }
+
+            static const std::size_t pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            std::size_t begin = offset / pageSize * pageSize;
+            std::size_t end = std::min(offset + size, m_size);
+            ::madvise(const_cast<unsigned char *>(m_data) + begin, end - begin, MADV_WILLNEED);
+#endif
+        }
+    };
+
+}
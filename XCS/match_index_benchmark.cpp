@@ -0,0 +1,111 @@
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstddef>
+
+#include "constants.h"
+#include "symbol.h"
+#include "classifier.h"
+#include "classifier_ptr_set.h"
+#include "population.h"
+#include "indexed_population.h"
+#include "packed_condition.h"
+#include "packed_classifier.h"
+#include "bit_sliced_match_index.h"
+#include "trie_match_index.h"
+#include "random.h"
+
+using namespace XCS;
+
+using BenchmarkCondition = PackedCondition;
+using BenchmarkConditionActionPair = PackedConditionActionPair<bool, bool, Symbol<bool>, BenchmarkCondition>;
+using BenchmarkClassifier = Classifier<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkConditionActionPair, Constants>;
+using BenchmarkClassifierPtrSet = ClassifierPtrSet<bool, BenchmarkClassifier, Constants>;
+
+template <class MatchIndex>
+using BenchmarkIndexedPopulation = IndexedPopulation<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, Constants, BenchmarkClassifierPtrSet, MatchIndex>;
+
+using LinearPopulation = Population<bool, bool, Symbol<bool>, BenchmarkCondition, BenchmarkClassifier, Constants, BenchmarkClassifierPtrSet>;
+using BitSlicedPopulation = BenchmarkIndexedPopulation<BitSlicedMatchIndex<bool, BenchmarkClassifier>>;
+using TriePopulation = BenchmarkIndexedPopulation<TrieMatchIndex<bool, BenchmarkCondition, BenchmarkClassifier>>;
+
+static std::vector<bool> randomSituation(std::size_t length)
+{
+    std::vector<bool> situation;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        situation.push_back(Random::nextInt(0, 1));
+    }
+    return situation;
+}
+
+// Runs the queries and returns the average time per query in microseconds
+template <class Population>
+double benchmark(const Population & population, const std::vector<std::vector<bool>> & situations, std::size_t & matchCount)
+{
+    matchCount = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto && situation : situations)
+    {
+        population.forEachMatchingClassifier(situation, [&](const std::shared_ptr<BenchmarkClassifier> &) {
+            ++matchCount;
+        });
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::micro>(end - begin).count() / situations.size();
+}
+
+// Usage: match_index_benchmark [length] [classifier count] [generalize probability] [query count]
+int main(int argc, char * argv[])
+{
+    std::size_t length = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 37;
+    std::size_t classifierCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 5000;
+    double generalizeProbability = (argc > 3) ? std::strtod(argv[3], nullptr) : 0.65;
+    std::size_t queryCount = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 1000;
+
+    Constants constants;
+    constants.generalizeProbability = generalizeProbability;
+
+    LinearPopulation linearPopulation(constants, { false, true });
+    BitSlicedPopulation bitSlicedPopulation(constants, { false, true });
+    TriePopulation triePopulation(constants, { false, true });
+
+    // Fill the populations with covering classifiers
+    for (std::size_t i = 0; i < classifierCount; ++i)
+    {
+        auto cl = std::make_shared<BenchmarkClassifier>(randomSituation(length), Random::nextInt(0, 1) == 1, 0, constants);
+        cl->condition.randomGeneralize(generalizeProbability);
+        linearPopulation.insert(cl);
+        bitSlicedPopulation.insert(cl);
+        triePopulation.insert(cl);
+    }
+
+    std::vector<std::vector<bool>> situations;
+    for (std::size_t i = 0; i < queryCount; ++i)
+    {
+        situations.push_back(randomSituation(length));
+    }
+
+    std::size_t linearMatchCount, bitSlicedMatchCount, trieMatchCount;
+    double linearTime = benchmark(linearPopulation, situations, linearMatchCount);
+    double bitSlicedTime = benchmark(bitSlicedPopulation, situations, bitSlicedMatchCount);
+    double trieTime = benchmark(triePopulation, situations, trieMatchCount);
+
+    std::cout << "index,us/query,matches" << std::endl;
+    std::cout << "linear," << linearTime << "," << linearMatchCount << std::endl;
+    std::cout << "bit-sliced," << bitSlicedTime << "," << bitSlicedMatchCount << std::endl;
+    std::cout << "trie," << trieTime << "," << trieMatchCount << std::endl;
+
+    if (bitSlicedMatchCount != linearMatchCount || trieMatchCount != linearMatchCount)
+    {
+        std::cerr << "Match counts differ between indexes" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,8 +1,12 @@
 ﻿#pragma once
 
 #include <memory>
-#include <unordered_map>
+#include <vector>
 #include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "profiler.h"
 
 namespace XCS
 {
@@ -15,11 +19,56 @@ namespace XCS
         using ClassifierPtrSet::m_constants;
         using ClassifierPtrSet::m_availableActions;
         using ClassifierPtrSet::m_set;
+        using ClassifierPtrSet::m_actionIndex;
+        using ClassifierPtrSet::eraseAt;
+
+        // Per-action data of [M] by action index, accumulated while [M] is formed so that
+        // the prediction array needs no second pass over the classifiers (the buffers
+        // are reused across regenerate() calls)
+        std::vector<bool> m_isActionCovered;
+        std::size_t m_coveredActionCount;
+        std::vector<double> m_predictionSums; // sum of prediction * fitness
+        std::vector<double> m_fitnessSums;
+
+        void resetActionSums()
+        {
+            m_isActionCovered.assign(m_actionIndex.size(), false);
+            m_coveredActionCount = 0;
+            m_predictionSums.assign(m_actionIndex.size(), 0.0);
+            m_fitnessSums.assign(m_actionIndex.size(), 0.0);
+        }
+
+        void accumulate(const Classifier & cl)
+        {
+            std::size_t idx = m_actionIndex.idx(cl.action);
+            if (!m_isActionCovered[idx])
+            {
+                m_isActionCovered[idx] = true;
+                ++m_coveredActionCount;
+            }
+            m_predictionSums[idx] += cl.prediction * cl.fitness;
+            m_fitnessSums[idx] += cl.fitness;
+        }
+
+        // Returns one of the actions not present in [M] uniformly at random
+        Action chooseUncoveredAction() const
+        {
+            assert(m_coveredActionCount < m_actionIndex.size());
+
+            std::size_t rank = Random::nextInt<std::size_t>(0, m_actionIndex.size() - m_coveredActionCount - 1);
+            for (std::size_t i = 0; ; ++i)
+            {
+                if (!m_isActionCovered[i] && rank-- == 0)
+                {
+                    return m_actionIndex.action(i);
+                }
+            }
+        }
 
         // GENERATE COVERING CLASSIFIER
-        virtual ClassifierPtr generateCoveringClassifier(const std::vector<T> & situation, const std::unordered_set<Action> & unselectedActions, uint64_t timeStamp) const
+        virtual ClassifierPtr generateCoveringClassifier(const Population & population, const std::vector<T> & situation, Action action, uint64_t timeStamp) const
         {
-            auto cl = std::make_shared<Classifier>(situation, Random::chooseFrom(unselectedActions), timeStamp, m_constants);
+            auto cl = population.makeClassifier(situation, action, timeStamp, m_constants);
             cl->condition.randomGeneralize(m_constants.generalizeProbability);
 
             return cl;
@@ -27,10 +76,15 @@ namespace XCS
 
     public:
         // Constructor
-        using ClassifierPtrSet::ClassifierPtrSet;
+        MatchSet(const Constants & constants, const std::unordered_set<Action> & availableActions) :
+            ClassifierPtrSet(constants, availableActions),
+            m_coveredActionCount(0)
+        {
+            resetActionSums();
+        }
 
         MatchSet(Population & population, const std::vector<T> & situation, uint64_t timeStamp, const Constants & constants, const std::unordered_set<Action> & availableActions) :
-            ClassifierPtrSet(constants, availableActions)
+            MatchSet(constants, availableActions)
         {
             regenerate(population, situation, timeStamp);
         }
@@ -42,32 +96,108 @@ namespace XCS
         virtual void regenerate(Population & population, const std::vector<T> & situation, uint64_t timeStamp)
         {
             // Set theta_mna (the minimal number of actions) to the number of action choices if theta_mna is 0
-            auto thetaMna = (m_constants.thetaMna == 0) ? m_availableActions.size() : m_constants.thetaMna;
+            auto thetaMna = (m_constants.thetaMna == 0) ? m_actionIndex.size() : m_constants.thetaMna;
 
-            auto unselectedActions = m_availableActions;
+            {
+                XCS_PROFILE_PHASE(Matching);
 
-            m_set.clear();
+                m_set.clear();
+                resetActionSums();
 
-            while (m_set.empty())
+                population.forEachMatchingClassifier(situation, [&](const ClassifierPtr & cl) {
+                    m_set.push_back(cl);
+                    accumulate(*cl);
+                });
+            }
+
+            // Generate classifiers covering the unselected actions
+            //   Covering classifiers match the situation, so they are added to [M] directly
+            //   instead of scanning [P] again. Deletion runs once per inserted classifier
+            //   and may remove members of [M] (including new ones), which are dropped
+            //   before the covered actions are counted again.
+            while (m_coveredActionCount < thetaMna)
             {
-                for (auto && cl : population)
+                XCS_PROFILE_PHASE(Covering);
+
+                std::size_t coveringCount = 0;
+                do
                 {
-                    if (cl->condition.matches(situation))
-                    {
-                        m_set.insert(cl);
-                        unselectedActions.erase(cl->action);
-                    }
-                }
+                    XCS_PROFILE_COUNT(Covering);
+                    auto cl = generateCoveringClassifier(population, situation, chooseUncoveredAction(), timeStamp);
+                    population.insert(cl);
+                    m_set.push_back(cl);
+                    accumulate(*cl);
+                    ++coveringCount;
+                } while (m_coveredActionCount < thetaMna);
 
-                // Generate classifiers covering the unselected actions
-                if (m_availableActions.size() - unselectedActions.size() < thetaMna)
+                for (std::size_t i = 0; i < coveringCount; ++i)
                 {
-                    population.insert(generateCoveringClassifier(situation, unselectedActions, timeStamp));
                     population.deleteExtraClassifiers();
-                    m_set.clear();
+                }
+
+                resetActionSums();
+                for (std::size_t i = 0; i < m_set.size(); )
+                {
+                    if (population.contains(m_set[i]))
+                    {
+                        accumulate(*m_set[i]);
+                        ++i;
+                    }
+                    else
+                    {
+                        eraseAt(i);
+                    }
                 }
             }
         }
+
+        // Accumulates the per-action sums of the classifiers matching the situation without
+        // forming [M] (for inference, where only the prediction array is needed)
+        virtual void regenerateActionSums(const Population & population, const std::vector<T> & situation)
+        {
+            m_set.clear();
+            resetActionSums();
+
+            population.forEachMatchingClassifier(situation, [&](const ClassifierPtr & cl) {
+                accumulate(*cl);
+            });
+        }
+
+        // Adds a classifier to [M] (keeping the per-action sums consistent)
+        void insert(const ClassifierPtr & cl)
+        {
+            ClassifierPtrSet::insert(cl);
+            accumulate(*cl);
+        }
+
+        void clear()
+        {
+            m_set.clear();
+            resetActionSums();
+        }
+
+        // The number of actions advocated by [M]
+        std::size_t coveredActionCount() const noexcept
+        {
+            return m_coveredActionCount;
+        }
+
+        bool isActionCovered(std::size_t actionIdx) const
+        {
+            return m_isActionCovered[actionIdx];
+        }
+
+        // The sum of prediction * fitness over the classifiers advocating the action
+        double predictionSum(std::size_t actionIdx) const
+        {
+            return m_predictionSums[actionIdx];
+        }
+
+        // The sum of fitness over the classifiers advocating the action
+        double fitnessSum(std::size_t actionIdx) const
+        {
+            return m_fitnessSums[actionIdx];
+        }
     };
 
 }
\ No newline at end of file
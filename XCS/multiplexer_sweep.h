@@ -0,0 +1,146 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#include "parameter_sweep.h"
+
+namespace XCS
+{
+
+    // Returns true if length is k + 2^k for some k > 0
+    inline bool isMultiplexerLength(std::size_t length)
+    {
+        std::size_t addressBitLength = 1;
+        while (addressBitLength + ((std::size_t)1 << addressBitLength) < length)
+        {
+            ++addressBitLength;
+        }
+        return addressBitLength + ((std::size_t)1 << addressBitLength) == length;
+    }
+
+    // The constants used for a multiplexer of the given length (the population size and
+    // generalization probability of baseConstants are replaced)
+    template <class Constants>
+    Constants multiplexerConstants(const Constants & baseConstants, std::size_t multiplexerLength)
+    {
+        Constants constants = baseConstants;
+
+        if (multiplexerLength == 3)
+        {
+            constants.maxPopulationClassifierCount = 200;
+        }
+        else if (multiplexerLength == 6)
+        {
+            constants.maxPopulationClassifierCount = 400;
+        }
+        else if (multiplexerLength == 11)
+        {
+            constants.maxPopulationClassifierCount = 800;
+        }
+        else if (multiplexerLength == 20)
+        {
+            constants.maxPopulationClassifierCount = 2000;
+            constants.generalizeProbability = 0.5;
+        }
+        else if (multiplexerLength == 37)
+        {
+            constants.maxPopulationClassifierCount = 5000;
+            constants.generalizeProbability = 0.65;
+        }
+        else
+        {
+            constants.maxPopulationClassifierCount = 50000;
+            constants.generalizeProbability = 0.75;
+        }
+
+        return constants;
+    }
+
+    // Runs the parameter sweep of a multiplexer experiment described by a config file
+    // (see ParameterSweep)
+    //   Besides the names of Constants, the config may sweep "environment" (only
+    //   "multiplexer") and "multiplexerLength" (default defaultMultiplexerLength), whose
+    //   default constants are multiplexerConstants(baseConstants, multiplexerLength).
+    //   Each run is an Experiment on makeEnvironment(multiplexerLength). Returns the
+    //   exit status of the program.
+    template <class Experiment, class Constants, class EnvironmentFactory>
+    int runMultiplexerSweep(const std::string & configFilename, const Constants & baseConstants, std::size_t defaultMultiplexerLength, EnvironmentFactory makeEnvironment)
+    {
+        std::ifstream config(configFilename);
+        if (!config)
+        {
+            std::cerr << "Cannot open " << configFilename << std::endl;
+            return 1;
+        }
+
+        try
+        {
+            ParameterSweep sweep(config);
+
+            // Environment and constants by combination (checked before anything runs)
+            std::vector<std::size_t> multiplexerLengths;
+            std::vector<Constants> constants;
+            for (std::size_t i = 0; i < sweep.pointCount(); ++i)
+            {
+                auto assignment = sweep.point(i);
+
+                std::size_t multiplexerLength = defaultMultiplexerLength;
+                for (auto && parameter : assignment)
+                {
+                    if (parameter.first == "environment" && parameter.second != "multiplexer")
+                    {
+                        throw std::invalid_argument("Unknown environment: " + parameter.second);
+                    }
+                    else if (parameter.first == "multiplexerLength")
+                    {
+                        multiplexerLength = ParameterSweep::parseUnsigned(parameter.first, parameter.second);
+                        if (!isMultiplexerLength(multiplexerLength))
+                        {
+                            throw std::invalid_argument("Invalid multiplexer length: " + parameter.second);
+                        }
+                    }
+                }
+
+                constants.push_back(multiplexerConstants(baseConstants, multiplexerLength));
+                for (auto && parameter : assignment)
+                {
+                    if (parameter.first != "environment" && parameter.first != "multiplexerLength" && !constants.back().set(parameter.first, parameter.second))
+                    {
+                        throw std::invalid_argument("Unknown parameter: " + parameter.first);
+                    }
+                }
+
+                multiplexerLengths.push_back(multiplexerLength);
+            }
+
+            std::ofstream outputFile;
+            if (!sweep.outputFilename().empty())
+            {
+                outputFile.open(sweep.outputFilename());
+                if (!outputFile)
+                {
+                    throw std::runtime_error("Cannot open " + sweep.outputFilename());
+                }
+            }
+
+            sweep.run([&](std::size_t pointIdx, uint64_t) {
+                return std::make_unique<Experiment>(makeEnvironment(multiplexerLengths[pointIdx]), constants[pointIdx]);
+            }, sweep.outputFilename().empty() ? std::cout : outputFile);
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+}
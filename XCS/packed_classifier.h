@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cassert>
+
+#include "classifier.h"
+
+namespace XCS
+{
+
+    template <typename T, typename Action, class Symbol, class Condition>
+    struct PackedConditionActionPair : public ConditionActionPair<T, Action, Symbol, Condition>
+    {
+        using ConditionActionPair<T, Action, Symbol, Condition>::condition;
+        using ConditionActionPair<T, Action, Symbol, Condition>::action;
+
+        // Constructor
+        using ConditionActionPair<T, Action, Symbol, Condition>::ConditionActionPair;
+
+        // Destructor
+        virtual ~PackedConditionActionPair() = default;
+
+        // IS MORE GENERAL
+        virtual bool isMoreGeneral(const ConditionActionPair<T, Action, Symbol, Condition> & cl) const override
+        {
+            assert(condition.size() == cl.condition.size());
+
+            if (condition.dontCareCount() <= cl.condition.dontCareCount())
+            {
+                return false;
+            }
+
+            return condition.isSpecializedBy(cl.condition);
+        }
+    };
+
+}
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <functional>
+
+#include "bits.h"
+#include "symbol.h"
+#include "random.h"
+#include "hash.h"
+#include "binary_stream.h"
+
+namespace XCS
+{
+
+    // Reference to one allele of a packed condition (returned by PackedCondition::operator[])
+    class PackedSymbolReference
+    {
+    private:
+        uint64_t & m_care;
+        uint64_t & m_value;
+        const uint64_t m_mask;
+
+    public:
+        // Constructor
+        PackedSymbolReference(uint64_t & care, uint64_t & value, uint64_t mask) : m_care(care), m_value(value), m_mask(mask) {}
+
+        PackedSymbolReference(const PackedSymbolReference & obj) = default;
+
+        bool isDontCare() const
+        {
+            return (m_care & m_mask) == 0;
+        }
+
+        bool value() const
+        {
+            assert(!isDontCare());
+            return (m_value & m_mask) != 0;
+        }
+
+        bool matches(bool value) const
+        {
+            return isDontCare() || this->value() == value;
+        }
+
+        void generalize()
+        {
+            m_care &= ~m_mask;
+            m_value &= ~m_mask;
+        }
+
+        operator Symbol<bool>() const
+        {
+            return isDontCare() ? Symbol<bool>('#') : Symbol<bool>(value());
+        }
+
+        PackedSymbolReference & operator= (bool value)
+        {
+            m_care |= m_mask;
+            m_value = value ? (m_value | m_mask) : (m_value & ~m_mask);
+            return *this;
+        }
+
+        PackedSymbolReference & operator= (const Symbol<bool> & symbol)
+        {
+            if (symbol.isDontCare())
+            {
+                generalize();
+            }
+            else
+            {
+                *this = symbol.value();
+            }
+            return *this;
+        }
+
+        PackedSymbolReference & operator= (const PackedSymbolReference & obj)
+        {
+            return *this = static_cast<Symbol<bool>>(obj);
+        }
+
+        // Swaps the referenced alleles (found by ADL from "using std::swap; swap(a, b);")
+        friend void swap(PackedSymbolReference lhs, PackedSymbolReference rhs)
+        {
+            Symbol<bool> tmp = lhs;
+            lhs = rhs;
+            rhs = tmp;
+        }
+    };
+
+    // The condition for binary XCS stored as bit-packed care mask and value words
+    //   Allele i is specific if bit i of the care mask is set, and its value is bit i of
+    //   the value words. Value bits are kept zero for "don't care" alleles and for the
+    //   padding bits of the last word so that conditions can be compared word by word.
+    //   The words of conditions up to inlineWordCount * 64 alleles are stored inside the
+    //   object (so a classifier made by Population::makeClassifier() keeps its condition
+    //   in its own arena block); longer conditions allocate them on the heap.
+    class PackedCondition
+    {
+    public:
+        // The number of care (and value) words stored inline
+        static constexpr std::size_t inlineWordCount = 4;
+
+    protected:
+        // Care words followed by value words
+        uint64_t m_inlineWords[inlineWordCount * 2];
+        std::unique_ptr<uint64_t[]> m_heapWords;
+        std::size_t m_wordCount;
+        std::size_t m_size;
+
+        uint64_t * care() noexcept
+        {
+            return m_heapWords ? m_heapWords.get() : m_inlineWords;
+        }
+
+        const uint64_t * care() const noexcept
+        {
+            return m_heapWords ? m_heapWords.get() : m_inlineWords;
+        }
+
+        uint64_t * value() noexcept
+        {
+            return care() + m_wordCount;
+        }
+
+        const uint64_t * value() const noexcept
+        {
+            return care() + m_wordCount;
+        }
+
+        // Sets the length and zeroes the words
+        void resize(std::size_t size)
+        {
+            m_size = size;
+            m_wordCount = Bits::wordCount(size);
+            if (m_wordCount > inlineWordCount)
+            {
+                m_heapWords.reset(new uint64_t[m_wordCount * 2]);
+            }
+            else
+            {
+                m_heapWords.reset();
+            }
+            std::fill(care(), care() + m_wordCount * 2, uint64_t(0));
+        }
+
+    public:
+        // The packed form of a situation accepted by matches()
+        using Situation = std::vector<uint64_t>;
+
+        // Constructor
+        PackedCondition() : m_wordCount(0), m_size(0) {}
+
+        PackedCondition(const PackedCondition & obj) : PackedCondition()
+        {
+            *this = obj;
+        }
+
+        PackedCondition(const std::vector<Symbol<bool>> & symbols) : PackedCondition()
+        {
+            resize(symbols.size());
+            for (std::size_t i = 0; i < m_size; ++i)
+            {
+                (*this)[i] = symbols[i];
+            }
+        }
+
+        PackedCondition(const std::vector<bool> & symbols) : PackedCondition()
+        {
+            resize(symbols.size());
+            Situation words = prepareSituation(symbols);
+            std::copy(words.begin(), words.end(), value());
+            std::fill(care(), care() + m_wordCount, ~uint64_t(0));
+            if (m_wordCount > 0)
+            {
+                care()[m_wordCount - 1] = Bits::lastWordMask(m_size);
+            }
+        }
+
+        PackedCondition(const std::string & symbols) : PackedCondition()
+        {
+            resize(symbols.size());
+            for (std::size_t i = 0; i < m_size; ++i)
+            {
+                (*this)[i] = Symbol<bool>(symbols[i]);
+            }
+        }
+
+        // Destructor
+        virtual ~PackedCondition() = default;
+
+        PackedCondition & operator= (const PackedCondition & obj)
+        {
+            if (this != &obj)
+            {
+                if (m_wordCount != obj.m_wordCount)
+                {
+                    resize(obj.m_size);
+                }
+                m_size = obj.m_size;
+                std::copy(obj.care(), obj.care() + m_wordCount * 2, care());
+            }
+            return *this;
+        }
+
+        // Packs a situation into words (call once per situation, then use matches() on the result)
+        static Situation prepareSituation(const std::vector<bool> & situation)
+        {
+            Situation words(Bits::wordCount(situation.size()), 0);
+            for (std::size_t i = 0; i < situation.size(); ++i)
+            {
+                if (situation[i])
+                {
+                    words[i / Bits::wordBitLength] |= uint64_t(1) << (i % Bits::wordBitLength);
+                }
+            }
+            return words;
+        }
+
+        virtual std::string toString() const
+        {
+            std::string str;
+            for (std::size_t i = 0; i < m_size; ++i)
+            {
+                str += at(i).toString();
+            }
+            return str;
+        }
+
+        PackedSymbolReference operator[] (std::size_t idx)
+        {
+            assert(idx < m_size);
+            return PackedSymbolReference(care()[idx / Bits::wordBitLength], value()[idx / Bits::wordBitLength], uint64_t(1) << (idx % Bits::wordBitLength));
+        }
+
+        Symbol<bool> at(std::size_t idx) const
+        {
+            assert(idx < m_size);
+            uint64_t mask = uint64_t(1) << (idx % Bits::wordBitLength);
+            if ((care()[idx / Bits::wordBitLength] & mask) == 0)
+            {
+                return Symbol<bool>('#');
+            }
+            return Symbol<bool>((value()[idx / Bits::wordBitLength] & mask) != 0);
+        }
+
+        friend std::ostream & operator<< (std::ostream & os, const PackedCondition & obj)
+        {
+            return os << obj.toString();
+        }
+
+        friend bool operator== (const PackedCondition & lhs, const PackedCondition & rhs)
+        {
+            return lhs.m_size == rhs.m_size && std::equal(lhs.care(), lhs.care() + lhs.m_wordCount * 2, rhs.care());
+        }
+
+        friend bool operator!= (const PackedCondition & lhs, const PackedCondition & rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+        // Returns the same value for equal conditions
+        std::size_t hash() const
+        {
+            std::size_t seed = m_size;
+            for (std::size_t i = 0; i < m_wordCount; ++i)
+            {
+                seed = hashCombine(seed, std::hash<uint64_t>()(care()[i]));
+                seed = hashCombine(seed, std::hash<uint64_t>()(value()[i]));
+            }
+            return seed;
+        }
+
+        // DOES MATCH
+        bool matches(const Situation & situation) const
+        {
+            assert(m_wordCount == situation.size());
+
+            const uint64_t * careWords = care();
+            const uint64_t * valueWords = value();
+            for (std::size_t i = 0; i < m_wordCount; ++i)
+            {
+                if (((situation[i] ^ valueWords[i]) & careWords[i]) != 0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        bool matches(const std::vector<bool> & situation) const
+        {
+            assert(m_size == situation.size());
+
+            return matches(prepareSituation(situation));
+        }
+
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        // The number of words in careWords() and valueWords()
+        std::size_t wordCount() const noexcept
+        {
+            return m_wordCount;
+        }
+
+        const uint64_t * careWords() const noexcept
+        {
+            return care();
+        }
+
+        const uint64_t * valueWords() const noexcept
+        {
+            return value();
+        }
+
+        // Exchanges the alleles [from, to) with another condition of the same length
+        void swapRange(PackedCondition & other, std::size_t from, std::size_t to)
+        {
+            assert(m_size == other.m_size);
+
+            uint64_t * careWords = care();
+            uint64_t * valueWords = value();
+            uint64_t * otherCareWords = other.care();
+            uint64_t * otherValueWords = other.value();
+            for (std::size_t i = from / Bits::wordBitLength; i < m_wordCount && i * Bits::wordBitLength < to; ++i)
+            {
+                uint64_t mask = Bits::rangeMask(i * Bits::wordBitLength, from, to);
+                uint64_t careDiff = (careWords[i] ^ otherCareWords[i]) & mask;
+                uint64_t valueDiff = (valueWords[i] ^ otherValueWords[i]) & mask;
+                careWords[i] ^= careDiff;
+                otherCareWords[i] ^= careDiff;
+                valueWords[i] ^= valueDiff;
+                otherValueWords[i] ^= valueDiff;
+            }
+        }
+
+        // Toggles the alleles in the mask of word idx between "don't care" and the situation value
+        void flip(std::size_t idx, uint64_t mask, uint64_t situationWord)
+        {
+            assert(idx < m_wordCount);
+
+            uint64_t & careWord = care()[idx];
+            uint64_t & valueWord = value()[idx];
+            mask &= (idx + 1 == m_wordCount) ? Bits::lastWordMask(m_size) : ~uint64_t(0);
+            valueWord = (valueWord & ~mask) | (situationWord & mask & ~careWord);
+            careWord ^= mask;
+        }
+
+        // Returns true if every specific allele of this condition is specific with the same value in cl
+        bool isSpecializedBy(const PackedCondition & cl) const
+        {
+            assert(m_size == cl.m_size);
+
+            const uint64_t * careWords = care();
+            const uint64_t * valueWords = value();
+            const uint64_t * clCareWords = cl.care();
+            const uint64_t * clValueWords = cl.value();
+            for (std::size_t i = 0; i < m_wordCount; ++i)
+            {
+                if ((careWords[i] & ~clCareWords[i]) != 0 || ((valueWords[i] ^ clValueWords[i]) & careWords[i]) != 0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        virtual void randomGeneralize(double generalizeProbability)
+        {
+            Random::forEachBernoulliSuccess(m_size, generalizeProbability, [&](std::size_t i) {
+                uint64_t mask = uint64_t(1) << (i % Bits::wordBitLength);
+                care()[i / Bits::wordBitLength] &= ~mask;
+                value()[i / Bits::wordBitLength] &= ~mask;
+            });
+        }
+
+        virtual std::size_t dontCareCount() const
+        {
+            std::size_t careCount = 0;
+            const uint64_t * careWords = care();
+            for (std::size_t i = 0; i < m_wordCount; ++i)
+            {
+                careCount += Bits::popCount(careWords[i]);
+            }
+
+            return m_size - careCount;
+        }
+
+        // Writes the length followed by the care and value words
+        void write(BinaryWriter & writer) const
+        {
+            writer.write<uint64_t>(m_size);
+            writer.writeBytes(care(), m_wordCount * sizeof(uint64_t));
+            writer.writeBytes(value(), m_wordCount * sizeof(uint64_t));
+        }
+
+        void read(BinaryReader & reader)
+        {
+            uint64_t size = reader.read<uint64_t>();
+            uint64_t wordCount = size / Bits::wordBitLength + ((size % Bits::wordBitLength != 0) ? 1 : 0);
+            reader.requireBytes(wordCount * 2 * sizeof(uint64_t));
+
+            resize(static_cast<std::size_t>(size));
+            reader.readBytes(care(), m_wordCount * sizeof(uint64_t));
+            reader.readBytes(value(), m_wordCount * sizeof(uint64_t));
+        }
+    };
+
+}
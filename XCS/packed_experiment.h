@@ -0,0 +1,28 @@
+#pragma once
+
+#include "experiment.h"
+#include "packed_condition.h"
+#include "packed_classifier.h"
+#include "packed_ga.h"
+
+namespace XCS
+{
+
+    // XCS for binary situations using the bit-packed condition representation
+    template <
+        typename Action,
+        class Symbol = Symbol<bool>,
+        class Condition = PackedCondition,
+        class ConditionActionPair = PackedConditionActionPair<bool, Action, Symbol, Condition>,
+        class Constants = Constants,
+        class Classifier = Classifier<bool, Action, Symbol, Condition, ConditionActionPair, Constants>,
+        class ClassifierPtrSet = ClassifierPtrSet<Action, Classifier, Constants>,
+        class Population = Population<bool, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet>,
+        class MatchSet = MatchSet<bool, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population>,
+        class PredictionArray = EpsilonGreedyPredictionArray<bool, Action, Symbol, Condition, Classifier, MatchSet>,
+        class GA = PackedGA<bool, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>,
+        class ActionSet = ActionSet<bool, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA>
+    >
+    using PackedExperiment = Experiment<bool, Action, Symbol, Condition, ConditionActionPair, Constants, Classifier, ClassifierPtrSet, Population, MatchSet, PredictionArray, GA, ActionSet>;
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include "ga.h"
+#include "bits.h"
+
+namespace XCS
+{
+
+    template <typename T, typename Action, class Symbol, class Condition, class Classifier, class Population, class Constants, class ClassifierPtrSet>
+    class PackedGA : public GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>
+    {
+    protected:
+        using GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::m_constants;
+        using GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::m_availableActions;
+        using GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::chooseOtherAction;
+
+        // APPLY CROSSOVER
+        virtual void crossover(Classifier & cl1, Classifier & cl2) const override
+        {
+            assert(cl1.condition.size() == cl2.condition.size());
+
+            std::size_t x = static_cast<std::size_t>(Random::nextDouble() * (cl1.condition.size() + 1));
+            std::size_t y = static_cast<std::size_t>(Random::nextDouble() * (cl1.condition.size() + 1));
+
+            if (x > y)
+            {
+                std::swap(x, y);
+            }
+
+            if (x + 1 < y)
+            {
+                cl1.condition.swapRange(cl2.condition, x + 1, y);
+            }
+        }
+
+        // APPLY MUTATION
+        virtual void mutate(Classifier & cl, const std::vector<T> & situation) const override
+        {
+            assert(cl.condition.size() == situation.size());
+
+            auto && preparedSituation = Condition::prepareSituation(situation);
+
+            Random::forEachBernoulliSuccess(cl.condition.size(), m_constants.mutationProbability, [&](std::size_t i) {
+                std::size_t wordIdx = i / Bits::wordBitLength;
+                cl.condition.flip(wordIdx, uint64_t(1) << (i % Bits::wordBitLength), preparedSituation[wordIdx]);
+            });
+
+            if ((Random::nextDouble() < m_constants.mutationProbability) && (m_availableActions.size() >= 2))
+            {
+                cl.action = chooseOtherAction(cl.action);
+            }
+        }
+
+    public:
+        // Constructor
+        using GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::GA;
+
+        // Destructor
+        virtual ~PackedGA() = default;
+    };
+
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <utility>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <cctype>
+#include <cstdint>
+#include <cstddef>
+
+#include "random.h"
+#include "experiment_runner.h"
+
+namespace XCS
+{
+
+    // One combination of swept parameter values as (name, value) pairs
+    using ParameterAssignment = std::vector<std::pair<std::string, std::string>>;
+
+    // Grid of parameter values read from a config file, with the settings of the runs
+    //   The config has one "name = value" or "name = value1, value2, ..." line per
+    //   parameter ('#' starts a comment). The settings below are read by the sweep
+    //   itself; every other name is a swept parameter, and the sweep runs each
+    //   combination of their values (the first parameter varies slowest)
+    //   repetitionCount times:
+    //     repetitionCount       repetitions per combination (default 10)
+    //     seed                  seed of the first repetition (default nondeterministic;
+    //                           repetition i uses seed + i for every combination)
+    //     threadCount           threads to run on (default 0 = hardware threads)
+    //     checkpointCount, explorationLoopCount, evaluationLoopCount
+    //                           the ExperimentSchedule of each repetition
+    //     output                file name of the results table (default standard output)
+    //   The meaning of the swept names is up to the experiment factory passed to run()
+    //   (e.g. Constants::set() and environment parameters).
+    class ParameterSweep
+    {
+    private:
+        std::vector<std::pair<std::string, std::vector<std::string>>> m_parameters;
+        ExperimentSchedule m_schedule;
+        std::size_t m_repetitionCount;
+        uint64_t m_seed;
+        std::size_t m_threadCount;
+        std::string m_outputFilename;
+
+        static std::string trim(const std::string & str)
+        {
+            std::size_t begin = 0;
+            std::size_t end = str.size();
+            while (begin < end && std::isspace(static_cast<unsigned char>(str[begin])))
+            {
+                ++begin;
+            }
+            while (end > begin && std::isspace(static_cast<unsigned char>(str[end - 1])))
+            {
+                --end;
+            }
+            return str.substr(begin, end - begin);
+        }
+
+        static std::vector<std::string> splitValues(const std::string & str)
+        {
+            std::vector<std::string> values;
+            std::size_t begin = 0;
+            for (std::size_t end; (end = str.find(',', begin)) != std::string::npos; begin = end + 1)
+            {
+                values.push_back(trim(str.substr(begin, end - begin)));
+            }
+            values.push_back(trim(str.substr(begin)));
+            return values;
+        }
+
+        static bool isSetting(const std::string & name)
+        {
+            return name == "repetitionCount" || name == "seed" || name == "threadCount"
+                || name == "checkpointCount" || name == "explorationLoopCount" || name == "evaluationLoopCount"
+                || name == "output";
+        }
+
+        void set(const std::string & name, const std::string & value)
+        {
+            if (name == "repetitionCount")
+            {
+                m_repetitionCount = parseUnsigned(name, value);
+            }
+            else if (name == "seed")
+            {
+                m_seed = parseUnsigned(name, value);
+            }
+            else if (name == "threadCount")
+            {
+                m_threadCount = parseUnsigned(name, value);
+            }
+            else if (name == "checkpointCount")
+            {
+                m_schedule.checkpointCount = parseUnsigned(name, value);
+            }
+            else if (name == "explorationLoopCount")
+            {
+                m_schedule.explorationLoopCount = parseUnsigned(name, value);
+            }
+            else if (name == "evaluationLoopCount")
+            {
+                m_schedule.evaluationLoopCount = parseUnsigned(name, value);
+            }
+            else if (name == "output")
+            {
+                m_outputFilename = value;
+            }
+        }
+
+    public:
+        // Constructor
+        //   Throws std::runtime_error (with the line number) on a malformed config
+        explicit ParameterSweep(std::istream & config) :
+            m_repetitionCount(10),
+            m_seed(Random::nondeterministicSeed()),
+            m_threadCount(0)
+        {
+            std::unordered_set<std::string> names; // swept parameters and settings read so far
+            std::string line;
+            for (std::size_t lineNumber = 1; std::getline(config, line); ++lineNumber)
+            {
+                line = trim(line.substr(0, line.find('#')));
+                if (line.empty())
+                {
+                    continue;
+                }
+
+                auto error = [lineNumber](const std::string & message) {
+                    return std::runtime_error("Line " + std::to_string(lineNumber) + ": " + message);
+                };
+
+                std::size_t separatorPos = line.find('=');
+                if (separatorPos == std::string::npos)
+                {
+                    throw error("Expected \"name = value\"");
+                }
+
+                std::string name = trim(line.substr(0, separatorPos));
+                auto values = splitValues(line.substr(separatorPos + 1));
+                if (name.empty())
+                {
+                    throw error("Missing parameter name");
+                }
+                for (auto && value : values)
+                {
+                    if (value.empty())
+                    {
+                        throw error("Missing value for " + name);
+                    }
+                }
+                if (!names.insert(name).second)
+                {
+                    throw error("Duplicate parameter " + name);
+                }
+
+                if (!isSetting(name))
+                {
+                    m_parameters.emplace_back(name, values);
+                    continue;
+                }
+
+                if (values.size() != 1)
+                {
+                    throw error("Setting " + name + " takes a single value");
+                }
+
+                try
+                {
+                    set(name, values[0]);
+                }
+                catch (const std::invalid_argument & e)
+                {
+                    throw error(e.what());
+                }
+            }
+
+            if (m_repetitionCount == 0)
+            {
+                throw std::runtime_error("repetitionCount must be positive");
+            }
+        }
+
+        // Throws std::invalid_argument if value is not an unsigned integer
+        static uint64_t parseUnsigned(const std::string & name, const std::string & value)
+        {
+            std::size_t length = 0;
+            unsigned long long result = 0;
+            try
+            {
+                result = std::stoull(value, &length);
+            }
+            catch (const std::exception &)
+            {
+                length = 0;
+            }
+
+            if (value.empty() || length != value.size() || value[0] == '-')
+            {
+                throw std::invalid_argument("Invalid value for " + name + ": \"" + value + "\"");
+            }
+
+            return result;
+        }
+
+        // The number of parameter combinations
+        std::size_t pointCount() const
+        {
+            std::size_t count = 1;
+            for (auto && parameter : m_parameters)
+            {
+                count *= parameter.second.size();
+            }
+            return count;
+        }
+
+        ParameterAssignment point(std::size_t pointIdx) const
+        {
+            ParameterAssignment assignment(m_parameters.size());
+            for (std::size_t i = m_parameters.size(); i-- > 0;)
+            {
+                auto && values = m_parameters[i].second;
+                assignment[i] = std::make_pair(m_parameters[i].first, values[pointIdx % values.size()]);
+                pointIdx /= values.size();
+            }
+            return assignment;
+        }
+
+        const ExperimentSchedule & schedule() const noexcept
+        {
+            return m_schedule;
+        }
+
+        std::size_t repetitionCount() const noexcept
+        {
+            return m_repetitionCount;
+        }
+
+        uint64_t seed() const noexcept
+        {
+            return m_seed;
+        }
+
+        std::size_t threadCount() const noexcept
+        {
+            return m_threadCount;
+        }
+
+        // Empty for standard output
+        const std::string & outputFilename() const noexcept
+        {
+            return m_outputFilename;
+        }
+
+        // Runs all repetitions of all combinations and writes the results table
+        //   makeExperiment(pointIdx, seed) returns a pointer to a new experiment for
+        //   point(pointIdx) (see ExperimentRunner::run()). All pointCount() *
+        //   repetitionCount() repetitions are scheduled on one pool of threadCount()
+        //   threads, so the pool stays saturated until the last repetition. The table has
+        //   a tab-separated header line and one row per combination and checkpoint: the
+        //   parameter values, the checkpoint (from 1), and the mean and standard
+        //   deviation of the evaluation results over the repetitions.
+        template <class ExperimentFactory>
+        void run(ExperimentFactory makeExperiment, std::ostream & os) const
+        {
+            std::size_t pointCount = this->pointCount();
+
+            std::vector<uint64_t> seeds;
+            for (std::size_t i = 0; i < pointCount; ++i)
+            {
+                for (std::size_t j = 0; j < m_repetitionCount; ++j)
+                {
+                    seeds.push_back(m_seed + j);
+                }
+            }
+
+            LearningCurveCollector collector(seeds.size(), m_schedule.checkpointCount);
+            ExperimentRunner runner(m_threadCount);
+            runner.run([&](std::size_t repetitionIdx, uint64_t seed) {
+                return makeExperiment(repetitionIdx / m_repetitionCount, seed);
+            }, seeds, m_schedule, collector);
+
+            os << "# seed = " << m_seed << std::endl;
+            for (auto && parameter : m_parameters)
+            {
+                os << parameter.first << '\t';
+            }
+            os << "checkpoint\tmean\tstandardDeviation" << std::endl;
+
+            for (std::size_t i = 0; i < pointCount; ++i)
+            {
+                auto assignment = point(i);
+                auto curve = collector.learningCurve(i * m_repetitionCount, m_repetitionCount);
+                for (std::size_t j = 0; j < curve.size(); ++j)
+                {
+                    for (auto && parameter : assignment)
+                    {
+                        os << parameter.second << '\t';
+                    }
+                    os << (j + 1) << '\t' << curve[j].mean << '\t' << curve[j].standardDeviation << '\n';
+                }
+            }
+            os.flush();
+        }
+    };
+
+}
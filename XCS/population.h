@@ -1,6 +1,24 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <unordered_set>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
 #include "random.h"
+#include "hash.h"
+#include "sum_tree.h"
+#include "slab_allocator.h"
+#include "flat_index.h"
+#include "binary_stream.h"
+#include "profiler.h"
 
 namespace XCS
 {
@@ -14,84 +32,597 @@ namespace XCS
         using ClassifierPtrSet::m_constants;
         using ClassifierPtrSet::m_availableActions;
 
+        // Storage of the classifiers created by makeClassifier()
+        std::shared_ptr<SlabArena> m_arena;
+
+        // Slots keyed by the hash of the condition and action of their classifiers (for
+        // finding identical classifiers in O(L) instead of scanning the population)
+        FlatIndex<std::size_t> m_identityIndex;
+
+        static std::size_t identityHash(const Condition & condition, Action action)
+        {
+            return hashCombine(condition.hash(), std::hash<Action>()(action));
+        }
+
+        // Bookkeeping of a classifier in the population
+        struct Entry
+        {
+            ClassifierPtr cl;
+
+            // Position in m_set
+            std::size_t position;
+
+            // Numerosity and fitness as counted in the running sums
+            uint64_t numerosity;
+            double fitness;
+        };
+
+        // Classifiers by slot (slots are reused, positions in m_set change on removal)
+        std::vector<Entry> m_entries;
+        std::vector<std::size_t> m_freeSlots;
+        FlatIndex<const Classifier *> m_slotIdxs;
+
+        // Running sums of numerosity and fitness over the population
+        uint64_t m_numerositySum;
+        double m_fitnessSum;
+
+        // Deletion votes split into the components of deletionVoteComponents()
+        //   vote = constantVote + averageFitness * scaledVote
+        // (the fitness term is classified against m_voteAverageFitness)
+        SumTree m_constantVotes;
+        SumTree m_scaledVotes;
+        double m_voteAverageFitness;
+
+        // The relative drift of the average fitness from m_voteAverageFitness above which
+        // all votes are reclassified (see deleteExtraClassifiers())
+        double m_voteRefreshTolerance;
+
         // DELETION VOTE
-        virtual double deletionVote(const Classifier & cl, double averageFitness) const
+        //   Returns the components (c, s) of the vote c + averageFitness * s, where
+        //   c = as * n and s = 0 for classifiers whose fitness is not considered, and
+        //   c = 0 and s = as * n / (F / n) otherwise
+        virtual std::pair<double, double> deletionVoteComponents(const Classifier & cl, double averageFitness) const
         {
             double vote = cl.actionSetSize * cl.numerosity;
 
             // Consider fitness for deletion vote
             if ((cl.experience > m_constants.thetaDel) && (cl.fitness / cl.numerosity < averageFitness))
             {
-                vote *= averageFitness / (cl.fitness / cl.numerosity);
+                return std::make_pair(0.0, vote / (cl.fitness / cl.numerosity));
+            }
+
+            return std::make_pair(vote, 0.0);
+        }
+
+        double deletionVote(const Classifier & cl, double averageFitness) const
+        {
+            auto components = deletionVoteComponents(cl, averageFitness);
+            return components.first + averageFitness * components.second;
+        }
+
+        void setDeletionVote(std::size_t slotIdx)
+        {
+            auto components = deletionVoteComponents(*m_entries[slotIdx].cl, m_voteAverageFitness);
+            m_constantVotes.set(slotIdx, components.first);
+            m_scaledVotes.set(slotIdx, components.second);
+        }
+
+        // Returns the slot of cl (or FlatIndex::npos if cl is not in the population)
+        //   The slot recorded in the classifier is tried first, so m_slotIdxs is only
+        //   probed for classifiers not in the population or shared with another one.
+        std::size_t slotIdxOf(const Classifier * cl) const
+        {
+            std::size_t slotIdx = cl->populationSlotIdx;
+            if (slotIdx < m_entries.size() && m_entries[slotIdx].cl.get() == cl)
+            {
+                return slotIdx;
+            }
+
+            return m_slotIdxs.find(cl);
+        }
+
+        void insertEntry(const ClassifierPtr & cl)
+        {
+            std::size_t slotIdx;
+            if (m_freeSlots.empty())
+            {
+                slotIdx = m_entries.size();
+                m_entries.emplace_back();
+                if (m_constantVotes.size() < m_entries.size())
+                {
+                    m_constantVotes.resize(m_entries.size() * 2);
+                    m_scaledVotes.resize(m_entries.size() * 2);
+                }
+            }
+            else
+            {
+                slotIdx = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+
+            m_entries[slotIdx] = { cl, m_set.size(), cl->numerosity, cl->fitness };
+            m_set.push_back(cl);
+            m_slotIdxs.insert(cl.get(), slotIdx);
+            m_identityIndex.insert(identityHash(cl->condition, cl->action), slotIdx);
+            cl->populationSlotIdx = slotIdx;
+            m_numerositySum += cl->numerosity;
+            m_fitnessSum += cl->fitness;
+            setDeletionVote(slotIdx);
+        }
+
+        void eraseEntry(std::size_t slotIdx)
+        {
+            auto && cl = m_entries[slotIdx].cl;
+            m_slotIdxs.erase(cl.get(), slotIdx);
+            m_identityIndex.erase(identityHash(cl->condition, cl->action), slotIdx);
+
+            // Swap-erase from m_set
+            std::size_t position = m_entries[slotIdx].position;
+            if (position + 1 != m_set.size())
+            {
+                m_set[position] = std::move(m_set.back());
+                m_entries[slotIdxOf(m_set[position].get())].position = position;
+            }
+            m_set.pop_back();
+
+            m_numerositySum -= m_entries[slotIdx].numerosity;
+            m_fitnessSum -= m_entries[slotIdx].fitness;
+            m_constantVotes.set(slotIdx, 0.0);
+            m_scaledVotes.set(slotIdx, 0.0);
+            m_entries[slotIdx].cl.reset();
+            m_freeSlots.push_back(slotIdx);
+        }
+
+        // Recomputes the sums and reclassifies all votes against the given average fitness
+        void refreshDeletionVotes()
+        {
+            m_numerositySum = 0;
+            m_fitnessSum = 0.0;
+            for (auto && entry : m_entries)
+            {
+                if (entry.cl)
+                {
+                    entry.numerosity = entry.cl->numerosity;
+                    entry.fitness = entry.cl->fitness;
+                    m_numerositySum += entry.numerosity;
+                    m_fitnessSum += entry.fitness;
+                }
             }
 
-            return vote;
+            m_voteAverageFitness = (m_numerositySum > 0) ? m_fitnessSum / m_numerositySum : 0.0;
+
+            for (std::size_t i = 0; i < m_entries.size(); ++i)
+            {
+                if (m_entries[i].cl)
+                {
+                    setDeletionVote(i);
+                }
+            }
         }
 
     public:
         // Constructor
-        using ClassifierPtrSet::ClassifierPtrSet;
+        Population(const Constants & constants, const std::unordered_set<Action> availableActions) :
+            ClassifierPtrSet(constants, availableActions),
+            m_arena(std::make_shared<SlabArena>()),
+            m_numerositySum(0),
+            m_fitnessSum(0.0),
+            m_voteAverageFitness(0.0),
+            m_voteRefreshTolerance(0.01)
+        {
+        }
+
+        Population(const std::unordered_set<ClassifierPtr> & set, const Constants & constants, const std::unordered_set<Action> availableActions) :
+            Population(constants, availableActions)
+        {
+            for (auto && cl : set)
+            {
+                insert(cl);
+            }
+        }
 
         // Destructor
         virtual ~Population() = default;
 
-        // INSERT IN POPULATION
-        virtual void insertOrIncrementNumerosity(const Classifier & cl)
+        // Creates a classifier in the slab storage of the population
+        //   The classifier and its shared_ptr control block share one arena block, and
+        //   blocks of removed classifiers are reused once their last reference (e.g. from
+        //   the previous action set) is dropped. The sets still share ownership through
+        //   shared_ptr (not 32-bit handles), so each insertion into [M] or [A] updates an
+        //   atomic reference count.
+        template <class... Args>
+        ClassifierPtr makeClassifier(Args && ... args) const
+        {
+            return std::allocate_shared<Classifier>(SlabAllocator<Classifier>(m_arena), std::forward<Args>(args)...);
+        }
+
+        // Reads a classifier written by Classifier::write() into the slab storage
+        ClassifierPtr readClassifier(BinaryReader & reader) const
+        {
+            auto cl = makeClassifier(Condition(), Action(), 0, m_constants);
+            cl->read(reader);
+            return cl;
+        }
+
+        // Writes the classifiers in iteration order with the bookkeeping of the deletion
+        // votes (slots, running sums and vote trees)
+        void write(BinaryWriter & writer) const
+        {
+            writer.write<uint64_t>(m_set.size());
+            for (auto && cl : m_set)
+            {
+                std::size_t slotIdx = slotIdxOf(cl.get());
+                auto && entry = m_entries[slotIdx];
+                writer.write<uint64_t>(slotIdx);
+                writer.write(entry.numerosity);
+                writer.write(entry.fitness);
+                cl->write(writer);
+            }
+
+            writer.write<uint64_t>(m_entries.size());
+            writer.write<uint64_t>(m_freeSlots.size());
+            for (auto && slotIdx : m_freeSlots)
+            {
+                writer.write<uint64_t>(slotIdx);
+            }
+
+            writer.write(m_numerositySum);
+            writer.write(m_fitnessSum);
+            m_constantVotes.write(writer);
+            m_scaledVotes.write(writer);
+            writer.write(m_voteAverageFitness);
+        }
+
+        // Replaces the population with the one written by write()
+        //   The classifiers are added through insert() in their original order (so
+        //   derived populations rebuild their indexes), and the bookkeeping is then
+        //   restored as written, so deletion continues exactly as in the written
+        //   population. Throws std::runtime_error (leaving the population empty) on
+        //   malformed data.
+        virtual void read(BinaryReader & reader)
+        {
+            clear();
+
+            try
+            {
+                struct ReadEntry
+                {
+                    std::size_t slotIdx;
+                    uint64_t numerosity;
+                    double fitness;
+                };
+
+                // Each classifier follows its slot index, numerosity and fitness
+                std::size_t size = reader.readLength(sizeof(uint64_t) * 3);
+                std::vector<ReadEntry> readEntries;
+                readEntries.reserve(size);
+                m_set.reserve(size);
+                m_slotIdxs.reserve(size);
+                m_identityIndex.reserve(size);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    ReadEntry readEntry;
+                    readEntry.slotIdx = static_cast<std::size_t>(reader.read<uint64_t>());
+                    reader.read(readEntry.numerosity);
+                    reader.read(readEntry.fitness);
+                    if (readEntry.numerosity == 0 || !(readEntry.fitness >= 0.0 && std::isfinite(readEntry.fitness)))
+                    {
+                        throw std::runtime_error("Invalid population data");
+                    }
+                    readEntries.push_back(readEntry);
+                    insert(readClassifier(reader));
+                }
+
+                std::size_t slotCount = static_cast<std::size_t>(reader.read<uint64_t>());
+                std::vector<std::size_t> freeSlots(reader.readLength(sizeof(uint64_t)));
+                for (auto && slotIdx : freeSlots)
+                {
+                    slotIdx = static_cast<std::size_t>(reader.read<uint64_t>());
+                }
+                if (size + freeSlots.size() != slotCount)
+                {
+                    throw std::runtime_error("Invalid population data");
+                }
+
+                // Move the classifiers to their original slots
+                std::vector<Entry> entries(slotCount);
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    auto && readEntry = readEntries[i];
+                    if (readEntry.slotIdx >= slotCount || entries[readEntry.slotIdx].cl)
+                    {
+                        throw std::runtime_error("Invalid population data");
+                    }
+
+                    entries[readEntry.slotIdx] = { m_set[i], i, readEntry.numerosity, readEntry.fitness };
+                }
+                for (auto && slotIdx : freeSlots)
+                {
+                    if (slotIdx >= slotCount || entries[slotIdx].cl)
+                    {
+                        throw std::runtime_error("Invalid population data");
+                    }
+                }
+                m_entries.swap(entries);
+                m_freeSlots.swap(freeSlots);
+                m_slotIdxs.clear();
+                m_identityIndex.clear();
+                for (std::size_t slotIdx = 0; slotIdx < slotCount; ++slotIdx)
+                {
+                    auto && cl = m_entries[slotIdx].cl;
+                    if (cl)
+                    {
+                        m_slotIdxs.insert(cl.get(), slotIdx);
+                        m_identityIndex.insert(identityHash(cl->condition, cl->action), slotIdx);
+                        cl->populationSlotIdx = slotIdx;
+                    }
+                }
+
+                reader.read(m_numerositySum);
+                reader.read(m_fitnessSum);
+                m_constantVotes.read(reader);
+                m_scaledVotes.read(reader);
+                reader.read(m_voteAverageFitness);
+
+                if (m_constantVotes.size() < slotCount || m_scaledVotes.size() != m_constantVotes.size() || !std::isfinite(m_fitnessSum) || !(m_voteAverageFitness >= 0.0 && std::isfinite(m_voteAverageFitness)))
+                {
+                    throw std::runtime_error("Invalid population data");
+                }
+
+                // The entries and votes are kept in step with the classifiers (see
+                //   updateDeletionVote()), so they must match the classifiers read exactly
+                uint64_t numerositySum = 0;
+                for (std::size_t i = 0; i < m_constantVotes.size(); ++i)
+                {
+                    auto components = std::make_pair(0.0, 0.0);
+                    if (i < slotCount && m_entries[i].cl)
+                    {
+                        auto && entry = m_entries[i];
+                        if (entry.numerosity != entry.cl->numerosity || entry.fitness != entry.cl->fitness)
+                        {
+                            throw std::runtime_error("Invalid population data");
+                        }
+                        numerositySum += entry.numerosity;
+                        components = deletionVoteComponents(*entry.cl, m_voteAverageFitness);
+                    }
+                    if (m_constantVotes.weight(i) != components.first || m_scaledVotes.weight(i) != components.second)
+                    {
+                        throw std::runtime_error("Invalid population data");
+                    }
+                }
+                if (numerositySum != m_numerositySum)
+                {
+                    throw std::runtime_error("Invalid population data");
+                }
+            }
+            catch (...)
+            {
+                clear();
+                throw;
+            }
+        }
+
+        // Every insertion into and removal from the population goes through these
+        // (derived populations override them to maintain their indexes)
+        virtual bool insert(const ClassifierPtr & cl)
         {
-            for (auto && c : m_set)
+            if (contains(cl))
             {
-                if (c->condition == cl.condition && c->action == cl.action)
+                return false;
+            }
+
+            insertEntry(cl);
+            return true;
+        }
+
+        virtual void erase(const ClassifierPtr & cl)
+        {
+            std::size_t slotIdx = slotIdxOf(cl.get());
+            if (slotIdx == FlatIndex<const Classifier *>::npos)
+            {
+                return;
+            }
+
+            eraseEntry(slotIdx); // may invalidate cl if it refers to an element of m_set
+        }
+
+        virtual void clear()
+        {
+            m_entries.clear();
+            m_freeSlots.clear();
+            m_slotIdxs.clear();
+            m_constantVotes.resize(0);
+            m_scaledVotes.resize(0);
+            m_numerositySum = 0;
+            m_fitnessSum = 0.0;
+            m_identityIndex.clear();
+            m_set.clear();
+        }
+
+        // Must be called after changing the numerosity, fitness, experience or action set
+        // size of a classifier in the population (keeps the deletion votes current)
+        virtual void updateDeletionVote(const ClassifierPtr & cl)
+        {
+            std::size_t slotIdx = slotIdxOf(cl.get());
+            if (slotIdx == FlatIndex<const Classifier *>::npos)
+            {
+                return;
+            }
+
+            auto && entry = m_entries[slotIdx];
+            m_numerositySum += cl->numerosity - entry.numerosity;
+            m_fitnessSum += cl->fitness - entry.fitness;
+            entry.numerosity = cl->numerosity;
+            entry.fitness = cl->fitness;
+            setDeletionVote(slotIdx);
+        }
+
+        // Does what updateDeletionVote() does for each of the classifiers, which are
+        // located by their slot handles (see slotIdxOf())
+        virtual void updateDeletionVotes(const std::vector<Classifier *> & classifiers)
+        {
+            for (auto && cl : classifiers)
+            {
+                std::size_t slotIdx = slotIdxOf(cl);
+                if (slotIdx == FlatIndex<const Classifier *>::npos)
                 {
-                    ++c->numerosity;
-                    return;
+                    continue;
                 }
+
+                auto && entry = m_entries[slotIdx];
+                m_numerositySum += cl->numerosity - entry.numerosity;
+                m_fitnessSum += cl->fitness - entry.fitness;
+                entry.numerosity = cl->numerosity;
+                entry.fitness = cl->fitness;
+                setDeletionVote(slotIdx);
             }
-            m_set.insert(std::make_shared<Classifier>(cl));
         }
 
-        // DELETE FROM POPULATION
-        virtual void deleteExtraClassifiers()
+        bool contains(const ClassifierPtr & cl) const
         {
-            uint64_t numerositySum = 0;
-            double fitnessSum = 0.0;
-            for (auto && c : m_set)
+            return slotIdxOf(cl.get()) != FlatIndex<const Classifier *>::npos;
+        }
+
+        // The sum of numerosities (the number of micro-classifiers)
+        uint64_t numerositySum() const noexcept
+        {
+            return m_numerositySum;
+        }
+
+        // Returns the classifier having the same condition and action as cl (or nullptr)
+        ClassifierPtr findIdentical(const Condition & condition, Action action) const
+        {
+            std::size_t slotIdx = m_identityIndex.findIf(identityHash(condition, action), [&](std::size_t idx) {
+                return m_entries[idx].cl->condition == condition && m_entries[idx].cl->action == action;
+            });
+
+            return (slotIdx != FlatIndex<std::size_t>::npos) ? m_entries[slotIdx].cl : nullptr;
+        }
+
+        // Calls f for each classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            auto && preparedSituation = Condition::prepareSituation(situation);
+
+            for (auto && cl : m_set)
             {
-                numerositySum += c->numerosity;
-                fitnessSum += c->fitness;
+                if (cl->condition.matches(preparedSituation))
+                {
+                    f(cl);
+                }
             }
+        }
+
+        // Calls f(cl, situationIdx) for each pair of a classifier and a situation it matches
+        //   Classifier-major: the situations are prepared in blocks small enough to stay
+        //   in cache, and each classifier is tested against a whole block before moving
+        //   on, so a classifier's condition is loaded once per block instead of once per
+        //   situation. Calls for one classifier are consecutive within a block.
+        template <class Function>
+        void forEachMatchingPair(const std::vector<std::vector<T>> & situations, Function f) const
+        {
+            constexpr std::size_t blockSize = 256;
+
+            std::vector<typename Condition::Situation> preparedSituations;
+            preparedSituations.reserve(std::min(blockSize, situations.size()));
+
+            for (std::size_t begin = 0; begin < situations.size(); begin += blockSize)
+            {
+                std::size_t end = std::min(begin + blockSize, situations.size());
+
+                preparedSituations.clear();
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    preparedSituations.push_back(Condition::prepareSituation(situations[i]));
+                }
 
+                for (auto && cl : m_set)
+                {
+                    for (std::size_t i = 0; i < preparedSituations.size(); ++i)
+                    {
+                        if (cl->condition.matches(preparedSituations[i]))
+                        {
+                            f(cl, begin + i);
+                        }
+                    }
+                }
+            }
+        }
+
+        // INSERT IN POPULATION
+        virtual void insertOrIncrementNumerosity(const Classifier & cl)
+        {
+            auto c = findIdentical(cl.condition, cl.action);
+            if (c)
+            {
+                ++c->numerosity;
+                updateDeletionVote(c);
+                return;
+            }
+            insert(makeClassifier(cl));
+        }
+
+        // DELETE FROM POPULATION
+        //   The running sums make the size check O(1), and the vote sum trees make the
+        //   roulette-wheel selection O(log N). A vote depends on the average fitness,
+        //   which moves with every update, so the trees hold its two components: the
+        //   total vote is (sum of c) + averageFitness * (sum of s), exact for the current
+        //   average. Only whether the fitness term applies to a classifier (F / n below
+        //   the average) is decided against m_voteAverageFitness; the votes are
+        //   reclassified once the average drifts more than m_voteRefreshTolerance from
+        //   it, so a classifier's vote is never off by more than that relative amount.
+        virtual void deleteExtraClassifiers()
+        {
             // Return if the sum of numerosity has not met its maximum limit
-            if (numerositySum < m_constants.maxPopulationClassifierCount)
+            if (m_numerositySum < m_constants.maxPopulationClassifierCount)
             {
                 return;
             }
 
+            XCS_PROFILE_PHASE(Deletion);
+            XCS_PROFILE_COUNT(Deletion);
+
             // The average fitness in the population
-            double averageFitness = fitnessSum / numerositySum;
+            double averageFitness = m_fitnessSum / m_numerositySum;
 
-            // Prepare weights for roulette-wheel selection
-            std::vector<double> votes;
-            votes.reserve(m_set.size());
-            std::vector<const ClassifierPtr *> targets;
-            for (auto && c : m_set)
+            if (std::fabs(averageFitness - m_voteAverageFitness) > m_voteRefreshTolerance * m_voteAverageFitness)
             {
-                votes.push_back(deletionVote(*c, averageFitness));
-                targets.push_back(&c);
+                refreshDeletionVotes();
+                averageFitness = m_voteAverageFitness;
             }
 
             // Roulette-wheel selection
-            std::size_t rouletteIdx = Random::rouletteWheelSelection(votes);
+            double constantVoteSum = m_constantVotes.total();
+            double voteSum = constantVoteSum + averageFitness * m_scaledVotes.total();
+
+            assert(voteSum > 0);
+
+            double choicePoint = Random::nextDouble(0.0, voteSum);
+            std::size_t slotIdx;
+            if (choicePoint < constantVoteSum || m_scaledVotes.total() <= 0.0)
+            {
+                slotIdx = m_constantVotes.find(std::min(choicePoint, constantVoteSum));
+            }
+            else
+            {
+                slotIdx = m_scaledVotes.find((choicePoint - constantVoteSum) / averageFitness);
+            }
+
+            ClassifierPtr cl = m_entries[slotIdx].cl;
+            assert(cl);
 
             // Distrust the selected classifier
-            if ((*targets[rouletteIdx])->numerosity > 1)
+            if (cl->numerosity > 1)
             {
-                (*targets[rouletteIdx])->numerosity--;
+                cl->numerosity--;
+                updateDeletionVote(cl);
             }
             else
             {
-                m_set.erase(*targets[rouletteIdx]);
+                erase(cl);
             }
         }
     };
 
-}
+}
\ No newline at end of file
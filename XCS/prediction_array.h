@@ -1,23 +1,92 @@
 #pragma once
 
+#include <memory>
 #include <vector>
-#include <unordered_map>
 #include <random>
+#include <cstddef>
+#include <cassert>
 #include <limits>
 #include <cfloat>
 #include <cmath>
 
+#include "random.h"
+
 namespace XCS
 {
 
+    // Per-action sums of the classifiers advocating an action in a match set
+    struct PredictionArraySums
+    {
+        double predictionSum; // sum of prediction * fitness
+        double fitnessSum;
+        bool isCovered;
+    };
+
+    // Computes the prediction arrays of several situations from their per-action sums
+    // and returns the action GreedyPredictionArray selects for each
+    //   sums[situationIdx * actions.size() + actionIdx] holds the sums of the action
+    //   actions[actionIdx], and the prediction arrays are stored in predictionArrays in
+    //   the same layout (NaN for actions not covered). Ties are broken, and situations
+    //   covering no action get an action, at random with random.
+    template <typename Action>
+    std::vector<Action> selectGreedyActions(const std::vector<Action> & actions, const std::vector<PredictionArraySums> & sums, std::vector<double> & predictionArrays, RandomEngine & random)
+    {
+        Random::Scope randomScope(random);
+
+        std::size_t actionCount = actions.size();
+        std::size_t situationCount = (actionCount > 0) ? sums.size() / actionCount : 0;
+
+        predictionArrays.assign(sums.size(), std::numeric_limits<double>::quiet_NaN());
+
+        std::vector<Action> selectedActions;
+        selectedActions.reserve(situationCount);
+
+        std::vector<Action> maxPAActions;
+        for (std::size_t i = 0; i < situationCount; ++i)
+        {
+            double maxPA = std::numeric_limits<double>::lowest();
+            maxPAActions.clear();
+            for (std::size_t j = 0; j < actionCount; ++j)
+            {
+                std::size_t idx = i * actionCount + j;
+                if (!sums[idx].isCovered)
+                {
+                    continue;
+                }
+
+                double pa = sums[idx].predictionSum;
+                if (fabs(sums[idx].fitnessSum) > 0.0)
+                {
+                    pa /= sums[idx].fitnessSum;
+                }
+                predictionArrays[idx] = pa;
+
+                if (fabs(maxPA - pa) < DBL_EPSILON) // maxPA == pa
+                {
+                    maxPAActions.push_back(actions[j]);
+                }
+                else if (maxPA < pa)
+                {
+                    maxPAActions.clear();
+                    maxPAActions.push_back(actions[j]);
+                    maxPA = pa;
+                }
+            }
+
+            selectedActions.push_back(maxPAActions.empty() ? Random::chooseFrom(actions) : Random::chooseFrom(maxPAActions));
+        }
+
+        return selectedActions;
+    }
+
     template <typename T, typename Action, class Symbol, class Condition, class Classifier, class MatchSet>
     class AbstractPredictionArray
     {
     protected:
         using ClassifierPtr = std::shared_ptr<Classifier>;
 
-        // PA (Prediction Array)
-        std::unordered_map<Action, double> m_pa;
+        // PA (Prediction Array) by action index
+        std::vector<double> m_pa;
 
         // Array of PA keys (for random action selection)
         std::vector<Action> m_paActions;
@@ -30,39 +99,44 @@ namespace XCS
 
     public:
         // GENERATE PREDICTION ARRAY
+        //   Reads the per-action sums accumulated by MatchSet::regenerate() (or
+        //   MatchSet::regenerateActionSums()) instead of iterating over [M].
         explicit AbstractPredictionArray(const MatchSet & matchSet)
         {
-            // FSA (Fitness Sum Array)
-            std::unordered_map<Action, double> fsa;
+            auto && actionIndex = matchSet.actionIndex();
 
-            for (auto && cl : matchSet)
-            {
-                if (m_pa.count(cl->action) == 0) {
-                    m_paActions.push_back(cl->action);
-                }
-                m_pa[cl->action] += cl->prediction * cl->fitness;
-                fsa[cl->action] += cl->fitness;
-            }
+            m_pa.assign(actionIndex.size(), 0.0);
 
             m_maxPA = std::numeric_limits<double>::lowest();
 
-            for (auto && pair : m_pa)
+            for (std::size_t idx = 0; idx < m_pa.size(); ++idx)
             {
-                if (fabs(fsa[pair.first]) > 0.0)
+                if (!matchSet.isActionCovered(idx))
+                {
+                    continue;
+                }
+
+                m_paActions.push_back(actionIndex.action(idx));
+
+                // FSA (Fitness Sum Array)
+                double fitnessSum = matchSet.fitnessSum(idx);
+
+                m_pa[idx] = matchSet.predictionSum(idx);
+                if (fabs(fitnessSum) > 0.0)
                 {
-                    pair.second /= fsa[pair.first];
+                    m_pa[idx] /= fitnessSum;
                 }
 
                 // Update the best actions
-                if (fabs(m_maxPA - pair.second) < DBL_EPSILON) // m_maxPA == pair.second
+                if (fabs(m_maxPA - m_pa[idx]) < DBL_EPSILON) // m_maxPA == m_pa[idx]
                 {
-                    m_maxPAActions.push_back(pair.first);
+                    m_maxPAActions.push_back(actionIndex.action(idx));
                 }
-                else if (m_maxPA < pair.second)
+                else if (m_maxPA < m_pa[idx])
                 {
                     m_maxPAActions.clear();
-                    m_maxPAActions.push_back(pair.first);
-                    m_maxPA = pair.second;
+                    m_maxPAActions.push_back(actionIndex.action(idx));
+                    m_maxPA = m_pa[idx];
                 }
             }
         }
@@ -72,7 +146,7 @@ namespace XCS
 
         virtual double max() const
         {
-            assert(m_maxPA == std::numeric_limits<double>::lowest());
+            assert(m_maxPA != std::numeric_limits<double>::lowest());
             return m_maxPA;
         }
 
@@ -0,0 +1,620 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <ostream>
+#include <locale>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define XCS_PROFILE_CLOCK_RDTSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Phase instrumentation of Experiment::run()
+//   Compiled in only if XCS_PROFILING is defined (e.g. -DXCS_PROFILING); otherwise the
+//   macros below expand to nothing and Experiment::profiler() stays empty.
+#if defined(XCS_PROFILING)
+#define XCS_PROFILE_SCOPE(profiler) XCS::Profiler::Scope xcsProfileScope(profiler)
+#define XCS_PROFILE_STEP() XCS::Profiler::StepTimer xcsProfileStepTimer
+#define XCS_PROFILE_PHASE(phase) XCS::Profiler::PhaseTimer xcsProfilePhaseTimer(XCS::ProfilePhase::phase)
+#define XCS_PROFILE_COUNT(event) XCS::Profiler::count(XCS::ProfileEvent::event)
+#else
+#define XCS_PROFILE_SCOPE(profiler) ((void)0)
+#define XCS_PROFILE_STEP() ((void)0)
+#define XCS_PROFILE_PHASE(phase) ((void)0)
+#define XCS_PROFILE_COUNT(event) ((void)0)
+#endif
+
+namespace XCS
+{
+
+    // Phases of a step (the time of a phase excludes the phases nested in it, e.g. the
+    // deletions run by covering and the GA)
+    enum class ProfilePhase : std::size_t
+    {
+        Environment,        // situation() and executeAction()
+        Matching,           // forming [M] from [P]
+        Covering,
+        PredictionArray,    // the prediction array, the action selection and forming [A]
+        ActionSetUpdate,    // the parameter updates of [A] (or [A]_-1)
+        Subsumption,        // action set subsumption and GA subsumption
+        GA,
+        Deletion,
+    };
+
+    constexpr std::size_t profilePhaseCount = 8;
+
+    inline const char * profilePhaseName(std::size_t phaseIdx)
+    {
+        static const char * const names[profilePhaseCount] = {
+            "environment", "matching", "covering", "prediction_array",
+            "action_set_update", "subsumption", "ga", "deletion"
+        };
+        return names[phaseIdx];
+    }
+
+    enum class ProfileEvent : std::size_t
+    {
+        Covering,       // covering classifiers generated
+        GA,             // GA invocations
+        Subsumption,    // classifiers subsumed (by a parent or by the action set subsumer)
+        Deletion,       // deletions from [P] (numerosity decrements)
+    };
+
+    constexpr std::size_t profileEventCount = 4;
+
+    inline const char * profileEventName(std::size_t eventIdx)
+    {
+        static const char * const names[profileEventCount] = { "covering", "ga", "subsumption", "deletion" };
+        return names[eventIdx];
+    }
+
+    // Time stamp counter (rdtsc on x86, std::chrono::steady_clock otherwise)
+    class ProfileClock
+    {
+    private:
+        static double calibrate()
+        {
+#if defined(XCS_PROFILE_CLOCK_RDTSC)
+            // Count ticks over 10 ms of the steady clock
+            auto startTime = std::chrono::steady_clock::now();
+            uint64_t startTick = now();
+            std::chrono::steady_clock::time_point time;
+            do
+            {
+                time = std::chrono::steady_clock::now();
+            } while (time - startTime < std::chrono::milliseconds(10));
+            uint64_t tickCount = now() - startTick;
+
+            double nanoseconds = std::chrono::duration<double, std::nano>(time - startTime).count();
+            return (tickCount > 0) ? nanoseconds / tickCount : 1.0;
+#else
+            return 1.0;
+#endif
+        }
+
+    public:
+        static uint64_t now()
+        {
+#if defined(XCS_PROFILE_CLOCK_RDTSC)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        // Calibrated on the first call
+        static double nanosecondsPerTick()
+        {
+            static const double value = calibrate();
+            return value;
+        }
+    };
+
+    // Histogram of latencies in nanoseconds
+    //   Log-linear buckets: values below 16 ns are exact, and each power of two above is
+    //   split into 16 buckets, so a quantile is within 6.25% of the recorded value. The
+    //   buckets are allocated on the first record.
+    class LatencyHistogram
+    {
+    private:
+        static constexpr std::size_t subBucketBits = 4;
+        static constexpr std::size_t subBucketCount = std::size_t(1) << subBucketBits;
+        static constexpr std::size_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+        std::vector<uint64_t> m_buckets;
+        uint64_t m_count;
+        double m_sum;
+        uint64_t m_max;
+
+        static std::size_t bucketIdx(uint64_t value)
+        {
+            if (value < subBucketCount)
+            {
+                return static_cast<std::size_t>(value);
+            }
+
+            std::size_t exponent = 63;
+            while ((value >> exponent) == 0)
+            {
+                --exponent;
+            }
+            std::size_t subBucketIdx = static_cast<std::size_t>(value >> (exponent - subBucketBits)) - subBucketCount;
+            return (exponent - subBucketBits + 1) * subBucketCount + subBucketIdx;
+        }
+
+        // The largest value of the bucket
+        static uint64_t bucketUpperBound(std::size_t idx)
+        {
+            if (idx < subBucketCount)
+            {
+                return idx;
+            }
+
+            std::size_t shift = idx / subBucketCount - 1;
+            uint64_t subBucket = subBucketCount + idx % subBucketCount;
+            return ((subBucket + 1) << shift) - 1;
+        }
+
+    public:
+        // Constructor
+        LatencyHistogram() : m_count(0), m_sum(0.0), m_max(0) {}
+
+        void record(uint64_t nanoseconds)
+        {
+            if (m_buckets.empty())
+            {
+                m_buckets.resize(bucketCount, 0);
+            }
+            ++m_buckets[bucketIdx(nanoseconds)];
+            ++m_count;
+            m_sum += static_cast<double>(nanoseconds);
+            m_max = std::max(m_max, nanoseconds);
+        }
+
+        void merge(const LatencyHistogram & other)
+        {
+            if (other.m_buckets.empty())
+            {
+                return;
+            }
+            if (m_buckets.empty())
+            {
+                m_buckets.resize(bucketCount, 0);
+            }
+            for (std::size_t i = 0; i < bucketCount; ++i)
+            {
+                m_buckets[i] += other.m_buckets[i];
+            }
+            m_count += other.m_count;
+            m_sum += other.m_sum;
+            m_max = std::max(m_max, other.m_max);
+        }
+
+        void clear()
+        {
+            std::fill(m_buckets.begin(), m_buckets.end(), 0);
+            m_count = 0;
+            m_sum = 0.0;
+            m_max = 0;
+        }
+
+        uint64_t count() const noexcept
+        {
+            return m_count;
+        }
+
+        // Nanoseconds
+        double sum() const noexcept
+        {
+            return m_sum;
+        }
+
+        uint64_t max() const noexcept
+        {
+            return m_max;
+        }
+
+        // Returns the upper bound of the bucket holding the q-quantile (0 <= q <= 1),
+        // or 0 if the histogram is empty
+        uint64_t quantile(double q) const
+        {
+            if (m_count == 0)
+            {
+                return 0;
+            }
+
+            uint64_t rank = static_cast<uint64_t>(q * m_count + 0.5);
+            rank = std::min(std::max<uint64_t>(rank, 1), m_count);
+
+            uint64_t cumulativeCount = 0;
+            for (std::size_t i = 0; i < bucketCount; ++i)
+            {
+                cumulativeCount += m_buckets[i];
+                if (cumulativeCount >= rank)
+                {
+                    return std::min(bucketUpperBound(i), m_max);
+                }
+            }
+            return m_max;
+        }
+    };
+
+    // Phase times, event counts and latency histograms of the steps of Experiment::run()
+    struct ProfileData
+    {
+        uint64_t stepCount = 0;
+
+        // The latency of a whole step
+        LatencyHistogram stepLatency;
+
+        // Total nanoseconds and number of timed calls per ProfilePhase
+        std::array<double, profilePhaseCount> phaseNanoseconds = {};
+        std::array<uint64_t, profilePhaseCount> phaseCallCounts = {};
+
+        // The time spent in each phase per step, over the steps that ran the phase
+        std::array<LatencyHistogram, profilePhaseCount> phaseLatencies;
+
+        // Counts per ProfileEvent
+        std::array<uint64_t, profileEventCount> eventCounts = {};
+
+        void merge(const ProfileData & other)
+        {
+            stepCount += other.stepCount;
+            stepLatency.merge(other.stepLatency);
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                phaseNanoseconds[i] += other.phaseNanoseconds[i];
+                phaseCallCounts[i] += other.phaseCallCounts[i];
+                phaseLatencies[i].merge(other.phaseLatencies[i]);
+            }
+            for (std::size_t i = 0; i < profileEventCount; ++i)
+            {
+                eventCounts[i] += other.eventCounts[i];
+            }
+        }
+
+        void clear()
+        {
+            *this = ProfileData();
+        }
+
+        // Writes a JSON object (times in seconds)
+        void writeJson(std::ostream & os) const
+        {
+            std::ostringstream json;
+            json.imbue(std::locale::classic());
+            json.precision(9);
+
+            auto writeLatency = [&json](const LatencyHistogram & histogram) {
+                json << "{ \"count\": " << histogram.count()
+                    << ", \"mean\": " << ((histogram.count() > 0) ? histogram.sum() / histogram.count() * 1e-9 : 0.0)
+                    << ", \"p50\": " << histogram.quantile(0.5) * 1e-9
+                    << ", \"p90\": " << histogram.quantile(0.9) * 1e-9
+                    << ", \"p99\": " << histogram.quantile(0.99) * 1e-9
+                    << ", \"p999\": " << histogram.quantile(0.999) * 1e-9
+                    << ", \"max\": " << histogram.max() * 1e-9 << " }";
+            };
+
+            json << "{\n";
+            json << "  \"steps\": " << stepCount << ",\n";
+            json << "  \"seconds\": " << stepLatency.sum() * 1e-9 << ",\n";
+            json << "  \"step_latency\": ";
+            writeLatency(stepLatency);
+            json << ",\n  \"phases\": {\n";
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                json << "    \"" << profilePhaseName(i) << "\": { \"seconds\": " << phaseNanoseconds[i] * 1e-9
+                    << ", \"calls\": " << phaseCallCounts[i] << ", \"step_latency\": ";
+                writeLatency(phaseLatencies[i]);
+                json << " }" << ((i + 1 < profilePhaseCount) ? ",\n" : "\n");
+            }
+            json << "  },\n  \"events\": {\n";
+            for (std::size_t i = 0; i < profileEventCount; ++i)
+            {
+                json << "    \"" << profileEventName(i) << "\": " << eventCounts[i] << ((i + 1 < profileEventCount) ? ",\n" : "\n");
+            }
+            json << "  }\n}\n";
+
+            os << json.str();
+        }
+
+        // Writes the Prometheus text exposition format (counters, and summaries for the
+        // latencies, with metric names starting with prefix)
+        void writePrometheus(std::ostream & os, const std::string & prefix = "xcs") const
+        {
+            std::ostringstream text;
+            text.imbue(std::locale::classic());
+            text.precision(9);
+
+            auto writeSummary = [&text](const std::string & name, const std::string & labels, const LatencyHistogram & histogram) {
+                for (double q : { 0.5, 0.9, 0.99, 0.999 })
+                {
+                    text << name << "{" << labels << (labels.empty() ? "" : ",") << "quantile=\"" << q << "\"} " << histogram.quantile(q) * 1e-9 << "\n";
+                }
+                std::string labelSet = labels.empty() ? "" : "{" + labels + "}";
+                text << name << "_sum" << labelSet << " " << histogram.sum() * 1e-9 << "\n";
+                text << name << "_count" << labelSet << " " << histogram.count() << "\n";
+            };
+
+            text << "# HELP " << prefix << "_steps_total Steps run by the experiment.\n";
+            text << "# TYPE " << prefix << "_steps_total counter\n";
+            text << prefix << "_steps_total " << stepCount << "\n";
+
+            text << "# HELP " << prefix << "_step_latency_seconds Latency of a step.\n";
+            text << "# TYPE " << prefix << "_step_latency_seconds summary\n";
+            writeSummary(prefix + "_step_latency_seconds", "", stepLatency);
+
+            text << "# HELP " << prefix << "_phase_seconds_total Time spent in each phase, excluding nested phases.\n";
+            text << "# TYPE " << prefix << "_phase_seconds_total counter\n";
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                text << prefix << "_phase_seconds_total{phase=\"" << profilePhaseName(i) << "\"} " << phaseNanoseconds[i] * 1e-9 << "\n";
+            }
+
+            text << "# HELP " << prefix << "_phase_calls_total Timed calls of each phase.\n";
+            text << "# TYPE " << prefix << "_phase_calls_total counter\n";
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                text << prefix << "_phase_calls_total{phase=\"" << profilePhaseName(i) << "\"} " << phaseCallCounts[i] << "\n";
+            }
+
+            text << "# HELP " << prefix << "_phase_step_latency_seconds Time spent in each phase per step that ran the phase.\n";
+            text << "# TYPE " << prefix << "_phase_step_latency_seconds summary\n";
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                writeSummary(prefix + "_phase_step_latency_seconds", std::string("phase=\"") + profilePhaseName(i) + "\"", phaseLatencies[i]);
+            }
+
+            text << "# HELP " << prefix << "_events_total Covering, GA, subsumption and deletion events.\n";
+            text << "# TYPE " << prefix << "_events_total counter\n";
+            for (std::size_t i = 0; i < profileEventCount; ++i)
+            {
+                text << prefix << "_events_total{event=\"" << profileEventName(i) << "\"} " << eventCounts[i] << "\n";
+            }
+
+            os << text.str();
+        }
+    };
+
+    // Collector of the ProfileData of an experiment
+    //   Experiment::run() installs the profiler of the experiment for the calling thread
+    //   (see Scope), and the XCS_PROFILE_* macros in the components record into it.
+    //   The data is kept per interval: checkpoint() ends the current interval (e.g.
+    //   when the experiment is checkpointed) and adds it to the total.
+    class Profiler
+    {
+    public:
+        class PhaseTimer;
+
+    private:
+        ProfileData m_interval;
+        ProfileData m_total;
+
+        // Ticks per phase in the current step
+        std::array<uint64_t, profilePhaseCount> m_stepPhaseTicks = {};
+        std::array<uint64_t, profilePhaseCount> m_stepPhaseCallCounts = {};
+
+        // The innermost running phase timer
+        PhaseTimer * m_activeTimer = nullptr;
+
+        static Profiler *& current()
+        {
+            thread_local Profiler * profiler = nullptr;
+            return profiler;
+        }
+
+        void endStep(uint64_t stepTicks)
+        {
+            double nanosecondsPerTick = ProfileClock::nanosecondsPerTick();
+
+            ++m_interval.stepCount;
+            m_interval.stepLatency.record(static_cast<uint64_t>(stepTicks * nanosecondsPerTick));
+
+            for (std::size_t i = 0; i < profilePhaseCount; ++i)
+            {
+                if (m_stepPhaseCallCounts[i] > 0)
+                {
+                    double nanoseconds = m_stepPhaseTicks[i] * nanosecondsPerTick;
+                    m_interval.phaseNanoseconds[i] += nanoseconds;
+                    m_interval.phaseCallCounts[i] += m_stepPhaseCallCounts[i];
+                    m_interval.phaseLatencies[i].record(static_cast<uint64_t>(nanoseconds));
+                    m_stepPhaseTicks[i] = 0;
+                    m_stepPhaseCallCounts[i] = 0;
+                }
+            }
+        }
+
+        static void writeFile(const std::string & filename, const std::string & content)
+        {
+            // Written to a temporary file and renamed, so that a reader (such as the
+            // Prometheus textfile collector) never sees a partial file
+            std::string temporaryFilename = filename + ".tmp";
+            {
+                std::ofstream file(temporaryFilename, std::ios::binary);
+                if (!file || !file.write(content.data(), static_cast<std::streamsize>(content.size())) || !file.flush())
+                {
+                    throw std::runtime_error("Cannot write " + temporaryFilename);
+                }
+            }
+            if (std::rename(temporaryFilename.c_str(), filename.c_str()) != 0)
+            {
+                std::remove(temporaryFilename.c_str());
+                throw std::runtime_error("Cannot write " + filename);
+            }
+        }
+
+    public:
+        // True if the instrumentation is compiled in (XCS_PROFILING)
+#if defined(XCS_PROFILING)
+        static constexpr bool isEnabled = true;
+#else
+        static constexpr bool isEnabled = false;
+#endif
+
+        // Installs a profiler for the current thread during its lifetime
+        class Scope
+        {
+        private:
+            Profiler * const m_prevProfiler;
+
+        public:
+            // Constructor
+            explicit Scope(Profiler & profiler) : m_prevProfiler(current())
+            {
+                current() = &profiler;
+            }
+
+            Scope(const Scope &) = delete;
+            Scope & operator= (const Scope &) = delete;
+
+            // Destructor
+            ~Scope()
+            {
+                current() = m_prevProfiler;
+            }
+        };
+
+        // Times a step (XCS_PROFILE_STEP())
+        class StepTimer
+        {
+        private:
+            Profiler * const m_profiler;
+            const uint64_t m_startTick;
+
+        public:
+            // Constructor
+            StepTimer() : m_profiler(current()), m_startTick(m_profiler ? ProfileClock::now() : 0) {}
+
+            StepTimer(const StepTimer &) = delete;
+            StepTimer & operator= (const StepTimer &) = delete;
+
+            // Destructor
+            ~StepTimer()
+            {
+                if (m_profiler)
+                {
+                    m_profiler->endStep(ProfileClock::now() - m_startTick);
+                }
+            }
+        };
+
+        // Times a phase (XCS_PROFILE_PHASE()), excluding the phases timed inside it
+        class PhaseTimer
+        {
+        private:
+            Profiler * const m_profiler;
+            const std::size_t m_phaseIdx;
+            PhaseTimer * m_parent;
+            uint64_t m_nestedTicks;
+            uint64_t m_startTick;
+
+        public:
+            // Constructor
+            explicit PhaseTimer(ProfilePhase phase) :
+                m_profiler(current()),
+                m_phaseIdx(static_cast<std::size_t>(phase)),
+                m_parent(nullptr),
+                m_nestedTicks(0),
+                m_startTick(0)
+            {
+                if (m_profiler)
+                {
+                    m_parent = m_profiler->m_activeTimer;
+                    m_profiler->m_activeTimer = this;
+                    m_startTick = ProfileClock::now();
+                }
+            }
+
+            PhaseTimer(const PhaseTimer &) = delete;
+            PhaseTimer & operator= (const PhaseTimer &) = delete;
+
+            // Destructor
+            ~PhaseTimer()
+            {
+                if (m_profiler)
+                {
+                    uint64_t ticks = ProfileClock::now() - m_startTick;
+                    m_profiler->m_stepPhaseTicks[m_phaseIdx] += ticks - std::min(m_nestedTicks, ticks);
+                    ++m_profiler->m_stepPhaseCallCounts[m_phaseIdx];
+                    m_profiler->m_activeTimer = m_parent;
+                    if (m_parent)
+                    {
+                        m_parent->m_nestedTicks += ticks;
+                    }
+                }
+            }
+        };
+
+        // Counts an event (XCS_PROFILE_COUNT())
+        static void count(ProfileEvent event)
+        {
+            if (Profiler * profiler = current())
+            {
+                ++profiler->m_interval.eventCounts[static_cast<std::size_t>(event)];
+            }
+        }
+
+        // The data since the last checkpoint()
+        const ProfileData & interval() const noexcept
+        {
+            return m_interval;
+        }
+
+        // The data of all intervals
+        ProfileData total() const
+        {
+            ProfileData data = m_total;
+            data.merge(m_interval);
+            return data;
+        }
+
+        // Ends the current interval and returns its data
+        ProfileData checkpoint()
+        {
+            ProfileData data = m_interval;
+            m_total.merge(m_interval);
+            m_interval.clear();
+            return data;
+        }
+
+        void clear()
+        {
+            m_interval.clear();
+            m_total.clear();
+        }
+
+        // Writes total() as JSON
+        //   Throws std::runtime_error if the file cannot be written.
+        void writeJson(const std::string & filename) const
+        {
+            std::ostringstream os;
+            total().writeJson(os);
+            writeFile(filename, os.str());
+        }
+
+        // Writes total() in the Prometheus text format (for the textfile collector of
+        // the node exporter)
+        //   Throws std::runtime_error if the file cannot be written.
+        void writePrometheus(const std::string & filename, const std::string & prefix = "xcs") const
+        {
+            std::ostringstream os;
+            total().writePrometheus(os, prefix);
+            writeFile(filename, os.str());
+        }
+    };
+
+}
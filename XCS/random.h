@@ -4,29 +4,197 @@
 #include <vector>
 #include <unordered_set>
 #include <cassert>
+#include <cstdint>
 #include <cstddef>
+#include <cmath>
+#include <limits>
+#include <iterator>
 #include <algorithm>
 
 namespace XCS
 {
 
-    class Random
+    // xoshiro256** pseudo-random number generator (satisfies UniformRandomBitGenerator)
+    //   Seeded with splitmix64 from one 64-bit value. jump() advances the state by 2^128
+    //   steps, so engines split from one seed produce non-overlapping streams.
+    class RandomEngine
     {
     private:
-        static std::random_device m_device;
+        uint64_t m_state[4];
+
+        static uint64_t rotateLeft(uint64_t x, int k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+
+    public:
+        using result_type = uint64_t;
+
+        // Constructor
+        explicit RandomEngine(uint64_t seed = 0)
+        {
+            this->seed(seed);
+        }
+
+        static constexpr result_type min()
+        {
+            return 0;
+        }
+
+        static constexpr result_type max()
+        {
+            return ~uint64_t(0);
+        }
+
+        void seed(uint64_t seed)
+        {
+            // splitmix64
+            for (auto && word : m_state)
+            {
+                uint64_t z = (seed += 0x9E3779B97F4A7C15);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+                word = z ^ (z >> 31);
+            }
+        }
+
+        result_type operator()()
+        {
+            uint64_t result = rotateLeft(m_state[1] * 5, 7) * 9;
+            uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotateLeft(m_state[3], 45);
+
+            return result;
+        }
 
-        static auto && engine()
+        // Returns a double in [0, 1) (the upper 53 bits of the next output)
+        double nextCanonical()
         {
-            static std::mt19937 engine(m_device());
+            return ((*this)() >> 11) * (1.0 / (uint64_t(1) << 53));
+        }
+
+        // Advances the state by 2^128 steps
+        void jump()
+        {
+            static const uint64_t jumpPolynomial[] = { 0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA, 0x39ABDC4529B1661C };
+
+            uint64_t state[4] = { 0, 0, 0, 0 };
+            for (auto && word : jumpPolynomial)
+            {
+                for (int b = 0; b < 64; ++b)
+                {
+                    if (word & (uint64_t(1) << b))
+                    {
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            state[i] ^= m_state[i];
+                        }
+                    }
+                    (*this)();
+                }
+            }
+
+            for (int i = 0; i < 4; ++i)
+            {
+                m_state[i] = state[i];
+            }
+        }
+
+        // Returns a copy of this engine and jumps this one past the stream of the copy
+        RandomEngine split()
+        {
+            RandomEngine engine(*this);
+            jump();
             return engine;
         }
 
+        friend bool operator== (const RandomEngine & lhs, const RandomEngine & rhs)
+        {
+            return std::equal(std::begin(lhs.m_state), std::end(lhs.m_state), std::begin(rhs.m_state));
+        }
+
+        friend bool operator!= (const RandomEngine & lhs, const RandomEngine & rhs)
+        {
+            return !(lhs == rhs);
+        }
+    };
+
+    // Random number utilities drawing from the engine of the current thread
+    //   Each thread starts with its own engine seeded from std::random_device. An
+    //   Experiment installs the engine it owns with Random::Scope while it runs, so all
+    //   components it calls (match set, GA, population, prediction arrays, environments)
+    //   draw from that engine and a run is reproducible from the experiment's seed.
+    class Random
+    {
+    private:
+        static RandomEngine *& currentEngine()
+        {
+            thread_local RandomEngine threadEngine(nondeterministicSeed());
+            thread_local RandomEngine * engine = &threadEngine;
+            return engine;
+        }
+
+        // inverseLog = 1 / log(1 - p)
+        static std::size_t nextGeometricFromInverseLog(double inverseLog)
+        {
+            // 1 - nextDouble() is in (0, 1], so the logarithm is finite
+            double failureCount = std::floor(std::log(1.0 - nextDouble()) * inverseLog);
+
+            // Clamp so that adding the result to an index cannot overflow
+            const double maxFailureCount = static_cast<double>(std::numeric_limits<std::size_t>::max() / 4);
+            return static_cast<std::size_t>(std::min(failureCount, maxFailureCount));
+        }
+
     public:
+        // Installs an engine for the current thread during its lifetime
+        class Scope
+        {
+        private:
+            RandomEngine * const m_prevEngine;
+
+        public:
+            // Constructor
+            explicit Scope(RandomEngine & engine) : m_prevEngine(currentEngine())
+            {
+                currentEngine() = &engine;
+            }
+
+            Scope(const Scope &) = delete;
+            Scope & operator= (const Scope &) = delete;
+
+            // Destructor
+            ~Scope()
+            {
+                currentEngine() = m_prevEngine;
+            }
+        };
+
+        static RandomEngine & engine()
+        {
+            return *currentEngine();
+        }
+
+        static uint64_t nondeterministicSeed()
+        {
+            std::random_device device;
+            return (static_cast<uint64_t>(device()) << 32) ^ device();
+        }
+
+        static double nextDouble()
+        {
+            return engine().nextCanonical();
+        }
+
         template <typename T = double>
-        static T nextDouble(T min = 0.0, T max = 1.0)
+        static T nextDouble(T min, T max)
         {
-            std::uniform_real_distribution<T> dist(min, max);
-            return dist(engine());
+            return min + static_cast<T>(engine().nextCanonical()) * (max - min);
         }
 
         template <typename T = int>
@@ -36,6 +204,44 @@ namespace XCS
             return dist(engine());
         }
 
+        // Returns the number of failures before the first success in Bernoulli trials
+        // with success probability p (0 < p <= 1), sampled by inversion from one draw
+        static std::size_t nextGeometric(double p)
+        {
+            assert(p > 0.0 && p <= 1.0);
+
+            return (p >= 1.0) ? 0 : nextGeometricFromInverseLog(1.0 / std::log1p(-p));
+        }
+
+        // Calls f(i), in increasing order, for each i in [0, n) selected independently
+        // with probability p
+        //   Equivalent to testing nextDouble() < p for every i, but the gaps between the
+        //   selected indices are sampled from the geometric distribution, so it draws
+        //   about n * p + 1 numbers instead of n.
+        template <class Function>
+        static void forEachBernoulliSuccess(std::size_t n, double p, Function f)
+        {
+            if (p <= 0.0 || n == 0)
+            {
+                return;
+            }
+
+            if (p >= 1.0)
+            {
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    f(i);
+                }
+                return;
+            }
+
+            double inverseLog = 1.0 / std::log1p(-p);
+            for (std::size_t i = nextGeometricFromInverseLog(inverseLog); i < n; i += nextGeometricFromInverseLog(inverseLog) + 1)
+            {
+                f(i);
+            }
+        }
+
         template <typename T>
         static auto chooseFrom(const std::vector<T> & container)
         {
@@ -50,9 +256,12 @@ namespace XCS
         template <typename T>
         static auto chooseFrom(const std::unordered_set<T> & container)
         {
-            std::vector<T> vec(container.size());
-            vec.insert(vec.end(), container.begin(), container.end());
-            return chooseFrom(vec);
+            auto size = container.size();
+
+            assert(size > 0);
+
+            std::uniform_int_distribution<decltype(size)> dist(0, size - 1);
+            return *std::next(std::begin(container), dist(engine()));
         }
 
         template <typename T>
@@ -118,6 +327,4 @@ namespace XCS
         }
     };
 
-    std::random_device Random::m_device;
-
 }
\ No newline at end of file
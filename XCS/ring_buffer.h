@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+namespace XCS
+{
+
+    // Bounded lock-free queue for one producer thread and one consumer thread
+    //   The capacity is rounded up to a power of two. tryPush() and tryPop() swap the
+    //   value with the slot instead of copying it, so the buffers of values such as
+    //   std::vector travel back and forth between the threads and are reused instead
+    //   of reallocated. Each thread keeps a cached copy of the other thread's index
+    //   and reloads it only when the queue looks full (or empty), and the two indices
+    //   are kept on separate cache lines.
+    template <typename T>
+    class SpscRingBuffer
+    {
+    private:
+        static constexpr std::size_t cacheLineSize = 64;
+
+        std::vector<T> m_slots;
+        const std::size_t m_mask;
+
+        // Written by the consumer
+        char m_headPadding[cacheLineSize];
+        std::atomic<std::size_t> m_head;
+        std::size_t m_cachedTail;
+
+        // Written by the producer
+        char m_tailPadding[cacheLineSize];
+        std::atomic<std::size_t> m_tail;
+        std::size_t m_cachedHead;
+        char m_endPadding[cacheLineSize];
+
+        static std::size_t roundUpToPowerOfTwo(std::size_t value)
+        {
+            std::size_t result = 1;
+            while (result < value)
+            {
+                result <<= 1;
+            }
+            return result;
+        }
+
+    public:
+        // Constructor
+        explicit SpscRingBuffer(std::size_t capacity) :
+            m_slots(roundUpToPowerOfTwo(capacity)),
+            m_mask(m_slots.size() - 1),
+            m_head(0),
+            m_cachedTail(0),
+            m_tail(0),
+            m_cachedHead(0)
+        {
+        }
+
+        SpscRingBuffer(const SpscRingBuffer &) = delete;
+        SpscRingBuffer & operator= (const SpscRingBuffer &) = delete;
+
+        // Producer: swaps value into the queue and returns false if the queue is full
+        //   (value receives the buffer of a previously popped value)
+        bool tryPush(T & value)
+        {
+            std::size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedHead == m_slots.size())
+            {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+                if (tail - m_cachedHead == m_slots.size())
+                {
+                    return false;
+                }
+            }
+
+            using std::swap;
+            swap(m_slots[tail & m_mask], value);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: swaps the oldest value out of the queue and returns false if the
+        // queue is empty
+        bool tryPop(T & value)
+        {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cachedTail)
+            {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cachedTail)
+                {
+                    return false;
+                }
+            }
+
+            using std::swap;
+            swap(m_slots[head & m_mask], value);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: removes the oldest value and returns false if the queue is empty
+        bool discard()
+        {
+            std::size_t head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cachedTail)
+            {
+                m_cachedTail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cachedTail)
+                {
+                    return false;
+                }
+            }
+
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // The number of queued values (exact on the consumer thread apart from values
+        // pushed concurrently)
+        std::size_t size() const noexcept
+        {
+            std::size_t head = m_head.load(std::memory_order_acquire);
+            return m_tail.load(std::memory_order_acquire) - head;
+        }
+
+        bool empty() const noexcept
+        {
+            return size() == 0;
+        }
+
+        std::size_t capacity() const noexcept
+        {
+            return m_slots.size();
+        }
+    };
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <new>
+#include <cstddef>
+#include <cassert>
+
+namespace XCS
+{
+
+    // Arena handing out fixed-size blocks carved from large slabs
+    //   The block size is fixed by the first allocation. Released blocks are kept in an
+    //   intrusive free list and reused before a new slab is allocated, so a workload
+    //   that allocates and releases objects of one type at a steady rate stops calling
+    //   the global allocator once it has reached its peak size. Not thread-safe.
+    class SlabArena
+    {
+    private:
+        struct FreeBlock
+        {
+            FreeBlock * next;
+        };
+
+        const std::size_t m_blocksPerSlab;
+        std::size_t m_blockSize;
+        std::vector<std::unique_ptr<unsigned char[]>> m_slabs;
+        std::size_t m_slabUsedCount; // the number of blocks carved from the last slab
+        FreeBlock * m_freeList;
+        std::size_t m_allocatedCount;
+
+    public:
+        // Constructor
+        explicit SlabArena(std::size_t blocksPerSlab = 256) :
+            m_blocksPerSlab(blocksPerSlab),
+            m_blockSize(0),
+            m_slabUsedCount(0),
+            m_freeList(nullptr),
+            m_allocatedCount(0)
+        {
+            assert(blocksPerSlab > 0);
+        }
+
+        SlabArena(const SlabArena &) = delete;
+        SlabArena & operator= (const SlabArena &) = delete;
+
+        // Destructor
+        ~SlabArena()
+        {
+            assert(m_allocatedCount == 0);
+        }
+
+        // Returns true if blocks of the given size are served by this arena
+        bool accepts(std::size_t size)
+        {
+            if (m_blockSize == 0)
+            {
+                m_blockSize = (std::max(size, sizeof(FreeBlock)) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+            }
+
+            return size <= m_blockSize && size + alignof(std::max_align_t) > m_blockSize;
+        }
+
+        void * allocate()
+        {
+            assert(m_blockSize > 0);
+
+            ++m_allocatedCount;
+
+            if (m_freeList != nullptr)
+            {
+                FreeBlock * block = m_freeList;
+                m_freeList = block->next;
+                return block;
+            }
+
+            if (m_slabs.empty() || m_slabUsedCount == m_blocksPerSlab)
+            {
+                m_slabs.emplace_back(new unsigned char[m_blockSize * m_blocksPerSlab]);
+                m_slabUsedCount = 0;
+            }
+
+            return m_slabs.back().get() + m_blockSize * m_slabUsedCount++;
+        }
+
+        void deallocate(void * ptr) noexcept
+        {
+            assert(m_allocatedCount > 0);
+
+            --m_allocatedCount;
+
+            FreeBlock * block = static_cast<FreeBlock *>(ptr);
+            block->next = m_freeList;
+            m_freeList = block;
+        }
+
+        // The number of blocks currently handed out
+        std::size_t allocatedCount() const noexcept
+        {
+            return m_allocatedCount;
+        }
+
+        // The number of blocks in all slabs
+        std::size_t capacity() const noexcept
+        {
+            return m_slabs.size() * m_blocksPerSlab;
+        }
+    };
+
+    // Allocator serving single objects from a shared SlabArena (other requests go to
+    // the global allocator)
+    //   Intended for std::allocate_shared, which allocates the object together with its
+    //   control block. Every copy holds a reference to the arena, so the arena outlives
+    //   the last object allocated from it.
+    template <typename T>
+    class SlabAllocator
+    {
+    private:
+        template <typename U>
+        friend class SlabAllocator;
+
+        std::shared_ptr<SlabArena> m_arena;
+
+        bool usesArena(std::size_t n) const
+        {
+            return n == 1 && alignof(T) <= alignof(std::max_align_t) && m_arena->accepts(sizeof(T));
+        }
+
+    public:
+        using value_type = T;
+
+        // Constructor
+        explicit SlabAllocator(const std::shared_ptr<SlabArena> & arena) noexcept : m_arena(arena) {}
+
+        template <typename U>
+        SlabAllocator(const SlabAllocator<U> & obj) noexcept : m_arena(obj.m_arena) {}
+
+        T * allocate(std::size_t n)
+        {
+            if (usesArena(n))
+            {
+                return static_cast<T *>(m_arena->allocate());
+            }
+
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T * ptr, std::size_t n) noexcept
+        {
+            if (usesArena(n))
+            {
+                m_arena->deallocate(ptr);
+                return;
+            }
+
+            ::operator delete(ptr);
+        }
+
+        template <typename U>
+        friend bool operator== (const SlabAllocator & lhs, const SlabAllocator<U> & rhs) noexcept
+        {
+            return lhs.m_arena == rhs.m_arena;
+        }
+
+        template <typename U>
+        friend bool operator!= (const SlabAllocator & lhs, const SlabAllocator<U> & rhs) noexcept
+        {
+            return lhs.m_arena != rhs.m_arena;
+        }
+    };
+
+}
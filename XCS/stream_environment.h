@@ -0,0 +1,483 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "environment.h"
+#include "dataset.h"
+#include "ring_buffer.h"
+
+namespace XCS
+{
+
+    // Connects to a Unix domain stream socket and returns the file descriptor
+    //   Throws std::runtime_error on failure.
+    inline int connectUnixSocket(const std::string & path)
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+        {
+            throw std::runtime_error(path + ": Socket path too long");
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+        {
+            throw std::runtime_error(path + ": " + std::strerror(errno));
+        }
+        if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error(path + ": " + std::strerror(error));
+        }
+
+        return fd;
+    }
+
+    // What the I/O thread does with a record when the queue is full
+    enum class StreamOverflowPolicy
+    {
+        // Wait until the learner takes a record (the writer of the stream is slowed
+        // down once the pipe or socket buffer fills up as well)
+        Block,
+
+        // Drop the new record (the stream is read at full speed and the learner sees
+        // the records that fit into the queue)
+        DropNewest,
+    };
+
+    struct StreamOptions
+    {
+        // The number of parsed records the queue holds (rounded up to a power of two)
+        std::size_t capacity = 4096;
+
+        StreamOverflowPolicy overflowPolicy = StreamOverflowPolicy::Block;
+
+        // If nonzero, waitForRecords() skips the oldest queued records when more than
+        // maxLag are waiting, so the learner keeps up with the stream
+        std::size_t maxLag = 0;
+
+        double correctReward = 1000.0;
+        double incorrectReward = 0.0;
+
+        // Close the file descriptor when the environment is destroyed
+        bool closesFileDescriptor = false;
+    };
+
+    // Counters of a StreamEnvironment (see StreamEnvironment::statistics())
+    struct StreamStatistics
+    {
+        // Valid records read from the stream (including dropped ones)
+        uint64_t receivedCount;
+
+        // Lines that are not valid records (skipped)
+        uint64_t malformedCount;
+
+        // Records dropped by StreamOverflowPolicy::DropNewest
+        uint64_t droppedCount;
+
+        // Records skipped by maxLag
+        uint64_t skippedCount;
+
+        // Records the learner has acted on
+        uint64_t consumedCount;
+
+        // Records waiting in the queue
+        uint64_t queuedCount;
+
+        // Seconds since the environment was constructed
+        double elapsedSeconds;
+
+        // The average learner throughput
+        double recordsPerSecond() const
+        {
+            return (elapsedSeconds > 0.0) ? consumedCount / elapsedSeconds : 0.0;
+        }
+    };
+
+    // Single-step environment learning online from CSV records on a file descriptor
+    //   (stdin, a pipe or a socket; see connectUnixSocket())
+    //   Each line "x1,x2,...,xL,label" is one situation and its label, and the reward
+    //   is correctReward if the action equals the label (incorrectReward otherwise),
+    //   as in DatasetEnvironment. A dedicated I/O thread reads and parses the stream
+    //   into a bounded lock-free queue (see SpscRingBuffer), so the learner only takes
+    //   ready situations from the queue and never waits on reading or parsing. Lines
+    //   that are not records of the situation length with a label in availableActions
+    //   (and 0 or 1 values for T = bool) are counted and skipped, except a header
+    //   line at the start of the stream.
+    //
+    //   Experiment::run() uses one record per step and waits if the queue is empty,
+    //   so the learner loop is
+    //     while (std::size_t count = environment->waitForRecords(1000))
+    //         experiment.run(count);
+    //   The environment cannot be cloned and must be used by one learner thread.
+    template <typename T, typename Action, class Symbol>
+    class StreamEnvironment final : public AbstractEnvironment<T, Action, Symbol>
+    {
+    private:
+        using AbstractEnvironment<T, Action, Symbol>::availableActions;
+
+        struct Record
+        {
+            std::vector<T> situation;
+            Action label;
+        };
+
+        const int m_fd;
+        const std::size_t m_situationLength;
+        const StreamOptions m_options;
+
+        // Popped by the learner thread
+        mutable SpscRingBuffer<Record> m_queue;
+
+        // Record of the current step (taken from the queue by situation())
+        mutable Record m_current;
+        mutable bool m_hasCurrent;
+        bool m_isEndOfProblem;
+
+        // Written by the I/O thread
+        std::atomic<uint64_t> m_receivedCount;
+        std::atomic<uint64_t> m_malformedCount;
+        std::atomic<uint64_t> m_droppedCount;
+        std::atomic<bool> m_isEndOfStream;
+        std::string m_errorMessage;
+
+        // Written by the learner thread
+        mutable std::atomic<uint64_t> m_skippedCount;
+        std::atomic<uint64_t> m_consumedCount;
+
+        const std::chrono::steady_clock::time_point m_startTime;
+        std::atomic<bool> m_isStopping;
+        std::thread m_thread;
+
+        // Spins, then yields, then sleeps
+        static void backoff(unsigned int & waitCount)
+        {
+            if (waitCount >= 128)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            else if (waitCount >= 64)
+            {
+                std::this_thread::yield();
+            }
+            ++waitCount;
+        }
+
+        // Returns false if the line is not a valid record
+        bool toRecord(const CsvRecordParser & parser, Record & record) const
+        {
+            auto && values = parser.values();
+            if (values.size() != m_situationLength)
+            {
+                return false;
+            }
+
+            Action label = static_cast<Action>(parser.label());
+            if (static_cast<int64_t>(label) != parser.label() || availableActions.count(label) == 0)
+            {
+                return false;
+            }
+
+            record.situation.resize(m_situationLength);
+            for (std::size_t i = 0; i < m_situationLength; ++i)
+            {
+                if (std::is_same<T, bool>::value && values[i] != 0.0 && values[i] != 1.0)
+                {
+                    return false;
+                }
+                record.situation[i] = static_cast<T>(values[i]);
+            }
+            record.label = label;
+
+            return true;
+        }
+
+        // Returns false if the environment is being destroyed
+        bool push(Record & record)
+        {
+            m_receivedCount.fetch_add(1, std::memory_order_relaxed);
+
+            unsigned int waitCount = 0;
+            while (!m_queue.tryPush(record))
+            {
+                if (m_options.overflowPolicy == StreamOverflowPolicy::DropNewest)
+                {
+                    m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+                if (m_isStopping.load(std::memory_order_relaxed))
+                {
+                    return false;
+                }
+                backoff(waitCount);
+            }
+            return true;
+        }
+
+        // Main loop of the I/O thread
+        void readStream()
+        {
+            std::vector<char> buffer(65536);
+            std::string line;
+            CsvRecordParser parser;
+            Record record;
+            bool isFirstLine = true;
+
+            try
+            {
+                while (!m_isStopping.load(std::memory_order_relaxed))
+                {
+                    // Wait in slices so that the destructor does not hang on a silent stream
+                    pollfd pollFd = { m_fd, POLLIN, 0 };
+                    int pollResult = ::poll(&pollFd, 1, 100);
+                    if (pollResult == 0 || (pollResult < 0 && errno == EINTR))
+                    {
+                        continue;
+                    }
+                    if (pollResult < 0)
+                    {
+                        throw std::runtime_error(std::strerror(errno));
+                    }
+
+                    ssize_t size = ::read(m_fd, buffer.data(), buffer.size());
+                    if (size < 0)
+                    {
+                        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+                        {
+                            continue;
+                        }
+                        throw std::runtime_error(std::strerror(errno));
+                    }
+
+                    // End of stream (an unterminated last line is still a record)
+                    bool isEnd = (size == 0);
+                    if (isEnd)
+                    {
+                        buffer[0] = '\n';
+                        size = line.empty() ? 0 : 1;
+                    }
+
+                    const char * begin = buffer.data();
+                    const char * end = begin + size;
+                    while (begin < end)
+                    {
+                        auto newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+                        if (newline == nullptr)
+                        {
+                            line.append(begin, end);
+                            break;
+                        }
+                        line.append(begin, newline);
+                        begin = newline + 1;
+
+                        if (!line.empty() && line.back() == '\r')
+                        {
+                            line.pop_back();
+                        }
+                        if (line.find_first_not_of(" \t") != std::string::npos)
+                        {
+                            if (parser.parse(line) && toRecord(parser, record))
+                            {
+                                if (!push(record))
+                                {
+                                    return;
+                                }
+                            }
+                            else if (!(isFirstLine && parser.numericFieldCount() == 0))
+                            {
+                                m_malformedCount.fetch_add(1, std::memory_order_relaxed);
+                            }
+                            isFirstLine = false;
+                        }
+                        line.clear();
+                    }
+
+                    if (isEnd)
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (const std::exception & e)
+            {
+                m_errorMessage = e.what();
+            }
+
+            m_isEndOfStream.store(true, std::memory_order_release);
+        }
+
+        // Skips the oldest queued records beyond maxLag
+        void skipLaggingRecords() const
+        {
+            if (m_options.maxLag == 0)
+            {
+                return;
+            }
+
+            for (std::size_t size = m_queue.size(); size > m_options.maxLag; --size)
+            {
+                if (!m_queue.discard())
+                {
+                    break;
+                }
+                m_skippedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Takes the next record from the queue, waiting if it is empty
+        //   Throws std::runtime_error at the end of the stream.
+        void takeRecord() const
+        {
+            unsigned int waitCount = 0;
+            while (!m_queue.tryPop(m_current))
+            {
+                if (m_isEndOfStream.load(std::memory_order_acquire) && m_queue.empty())
+                {
+                    throw std::runtime_error(m_errorMessage.empty() ? "End of stream" : "End of stream: " + m_errorMessage);
+                }
+                backoff(waitCount);
+            }
+            m_hasCurrent = true;
+        }
+
+    public:
+        // Constructor
+        //   Starts the I/O thread reading records of situationLength values from fd.
+        StreamEnvironment(int fd, std::size_t situationLength, const std::unordered_set<Action> & availableActions, const StreamOptions & options = StreamOptions()) :
+            AbstractEnvironment<T, Action, Symbol>(availableActions),
+            m_fd(fd),
+            m_situationLength(situationLength),
+            m_options(options),
+            m_queue(std::max<std::size_t>(options.capacity, 1)),
+            m_current(),
+            m_hasCurrent(false),
+            m_isEndOfProblem(false),
+            m_receivedCount(0),
+            m_malformedCount(0),
+            m_droppedCount(0),
+            m_isEndOfStream(false),
+            m_skippedCount(0),
+            m_consumedCount(0),
+            m_startTime(std::chrono::steady_clock::now()),
+            m_isStopping(false)
+        {
+            m_thread = std::thread(&StreamEnvironment::readStream, this);
+        }
+
+        StreamEnvironment(const StreamEnvironment &) = delete;
+        StreamEnvironment & operator= (const StreamEnvironment &) = delete;
+
+        // Destructor
+        ~StreamEnvironment()
+        {
+            m_isStopping.store(true, std::memory_order_relaxed);
+            m_thread.join();
+            if (m_options.closesFileDescriptor)
+            {
+                ::close(m_fd);
+            }
+        }
+
+        // Waits until a record is available and returns the number of steps (up to
+        // maxCount) that can run without waiting, or 0 at the end of the stream
+        std::size_t waitForRecords(std::size_t maxCount)
+        {
+            unsigned int waitCount = 0;
+            while (!m_hasCurrent && m_queue.empty())
+            {
+                if (m_isEndOfStream.load(std::memory_order_acquire) && m_queue.empty())
+                {
+                    return 0;
+                }
+                backoff(waitCount);
+            }
+
+            skipLaggingRecords();
+
+            // Skipping during the steps leaves maxLag records queued
+            std::size_t count = std::min(maxCount, m_queue.size() + (m_hasCurrent ? 1 : 0));
+            return (m_options.maxLag > 0) ? std::min(count, m_options.maxLag) : count;
+        }
+
+        std::vector<T> situation() const override
+        {
+            if (!m_hasCurrent)
+            {
+                skipLaggingRecords();
+                takeRecord();
+            }
+            return m_current.situation;
+        }
+
+        double executeAction(Action action) override
+        {
+            if (!m_hasCurrent)
+            {
+                takeRecord();
+            }
+
+            double reward = (action == m_current.label) ? m_options.correctReward : m_options.incorrectReward;
+            m_hasCurrent = false;
+            m_consumedCount.fetch_add(1, std::memory_order_relaxed);
+
+            // Single-step problem
+            m_isEndOfProblem = true;
+
+            return reward;
+        }
+
+        bool isEndOfProblem() const override
+        {
+            return m_isEndOfProblem;
+        }
+
+        // Returns true if the stream has ended and every record has been used
+        bool isEndOfStream() const
+        {
+            return !m_hasCurrent && m_isEndOfStream.load(std::memory_order_acquire) && m_queue.empty();
+        }
+
+        // The error that ended the stream (empty at a normal end of the stream)
+        std::string errorMessage() const
+        {
+            return m_isEndOfStream.load(std::memory_order_acquire) ? m_errorMessage : std::string();
+        }
+
+        // Can be called from any thread
+        StreamStatistics statistics() const
+        {
+            StreamStatistics statistics;
+            statistics.receivedCount = m_receivedCount.load(std::memory_order_relaxed);
+            statistics.malformedCount = m_malformedCount.load(std::memory_order_relaxed);
+            statistics.droppedCount = m_droppedCount.load(std::memory_order_relaxed);
+            statistics.skippedCount = m_skippedCount.load(std::memory_order_relaxed);
+            statistics.consumedCount = m_consumedCount.load(std::memory_order_relaxed);
+            statistics.queuedCount = m_queue.size();
+            statistics.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+            return statistics;
+        }
+    };
+
+}
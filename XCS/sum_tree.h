@@ -0,0 +1,183 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+#include <cassert>
+
+#include "binary_stream.h"
+
+namespace XCS
+{
+
+    // Fenwick tree over non-negative weights for O(log N) roulette-wheel selection
+    //   set() updates a weight and find() returns the index whose cumulative range
+    //   contains a point in [0, total()). Repeated floating-point deltas drift, so the
+    //   tree rebuilds itself from the stored weights after as many updates as it has
+    //   elements (amortized O(1) per update).
+    class SumTree
+    {
+    private:
+        std::vector<double> m_weights;
+        std::vector<double> m_tree; // 1-based
+        double m_total;
+        std::size_t m_updateCount;
+
+        void add(std::size_t idx, double delta)
+        {
+            for (std::size_t i = idx + 1; i < m_tree.size(); i += i & (~i + 1))
+            {
+                m_tree[i] += delta;
+            }
+            m_total += delta;
+        }
+
+    public:
+        // Constructor
+        SumTree() : m_tree(1, 0.0), m_total(0.0), m_updateCount(0) {}
+
+        std::size_t size() const noexcept
+        {
+            return m_weights.size();
+        }
+
+        double total() const noexcept
+        {
+            return m_total;
+        }
+
+        double weight(std::size_t idx) const
+        {
+            return m_weights[idx];
+        }
+
+        // Resizes the tree (new weights are zero)
+        void resize(std::size_t size)
+        {
+            m_weights.resize(size, 0.0);
+            rebuild();
+        }
+
+        void set(std::size_t idx, double weight)
+        {
+            assert(idx < m_weights.size());
+            assert(weight >= 0.0);
+
+            if (++m_updateCount > m_weights.size())
+            {
+                m_weights[idx] = weight;
+                rebuild();
+                return;
+            }
+
+            add(idx, weight - m_weights[idx]);
+            m_weights[idx] = weight;
+        }
+
+        // Recomputes the partial sums from the weights in O(N)
+        void rebuild()
+        {
+            m_tree.assign(m_weights.size() + 1, 0.0);
+            m_total = 0.0;
+            for (std::size_t i = 1; i < m_tree.size(); ++i)
+            {
+                m_tree[i] += m_weights[i - 1];
+                m_total += m_weights[i - 1];
+
+                std::size_t parent = i + (i & (~i + 1));
+                if (parent < m_tree.size())
+                {
+                    m_tree[parent] += m_tree[i];
+                }
+            }
+            m_updateCount = 0;
+        }
+
+        // Returns the index i such that sum(weights[0, i)) <= point < sum(weights[0, i]),
+        // skipping zero weights (point must be in [0, total()))
+        std::size_t find(double point) const
+        {
+            assert(!m_weights.empty());
+
+            std::size_t pos = 0;
+            std::size_t step = 1;
+            while (step * 2 < m_tree.size())
+            {
+                step *= 2;
+            }
+
+            for (; step > 0; step /= 2)
+            {
+                if (pos + step < m_tree.size() && m_tree[pos + step] <= point)
+                {
+                    pos += step;
+                    point -= m_tree[pos];
+                }
+            }
+
+            // Guard against rounding at the upper end
+            if (pos >= m_weights.size() || m_weights[pos] <= 0.0)
+            {
+                for (pos = m_weights.size(); pos-- > 0;)
+                {
+                    if (m_weights[pos] > 0.0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            return pos;
+        }
+
+        // Writes the weights and the partial sums as they are (a tree read back selects
+        // exactly as this one does)
+        void write(BinaryWriter & writer) const
+        {
+            writer.writeVector(m_weights);
+            writer.writeVector(m_tree);
+            writer.write(m_total);
+            writer.write<uint64_t>(m_updateCount);
+        }
+
+        void read(BinaryReader & reader)
+        {
+            reader.readVector(m_weights);
+            reader.readVector(m_tree);
+            reader.read(m_total);
+            m_updateCount = static_cast<std::size_t>(reader.read<uint64_t>());
+
+            if (m_tree.size() != m_weights.size() + 1)
+            {
+                throw std::runtime_error("Invalid sum tree data");
+            }
+            for (auto && weight : m_weights)
+            {
+                if (!(weight >= 0.0 && std::isfinite(weight)))
+                {
+                    throw std::runtime_error("Invalid sum tree data");
+                }
+            }
+
+            // The stored partial sums may have drifted from the weights, but only by rounding
+            SumTree exact;
+            exact.m_weights = m_weights;
+            exact.rebuild();
+            double tolerance = 1e-6 * exact.m_total;
+            for (std::size_t i = 0; i < m_tree.size(); ++i)
+            {
+                if (!(std::fabs(m_tree[i] - exact.m_tree[i]) <= tolerance))
+                {
+                    throw std::runtime_error("Invalid sum tree data");
+                }
+            }
+            if (!(std::fabs(m_total - exact.m_total) <= tolerance))
+            {
+                throw std::runtime_error("Invalid sum tree data");
+            }
+        }
+    };
+
+}
@@ -5,6 +5,9 @@
 #include <vector>
 #include <cstdint>
 #include <cassert>
+#include <functional>
+
+#include "binary_stream.h"
 
 namespace XCS
 {
@@ -67,6 +70,12 @@ namespace XCS
                 return std::to_string(value());
         }
 
+        // Returns the same value for equal symbols
+        std::size_t hash() const
+        {
+            return isDontCare() ? 0 : std::hash<T>()(value()) + 1;
+        }
+
         friend bool operator== (const Symbol<T> & lhs, const Symbol<T> & rhs)
         {
             return lhs.isDontCare() == rhs.isDontCare() && (lhs.isDontCare() || lhs.value() == rhs.value());
@@ -94,6 +103,18 @@ namespace XCS
         {
             m_isDontCare = true;
         }
+
+        void write(BinaryWriter & writer) const
+        {
+            writer.write(m_value);
+            writer.write(m_isDontCare);
+        }
+
+        void read(BinaryReader & reader)
+        {
+            reader.read(m_value);
+            reader.read(m_isDontCare);
+        }
     };
 
     template <>
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <cstddef>
+
+namespace XCS
+{
+
+    // Fixed set of worker threads running queued tasks
+    //   parallelFor() is the only entry point: the calling thread works on the loop
+    //   together with the workers and returns when every iteration has finished.
+    //   Iterations are distributed by work stealing (see parallelFor()).
+    class ThreadPool
+    {
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_taskAvailable;
+        bool m_isStopping;
+
+        // Iterations [begin, end) of a parallelFor() not yet taken by a thread
+        struct WorkRange
+        {
+            std::mutex mutex;
+            std::size_t begin;
+            std::size_t end;
+
+            bool pop(std::size_t & idx)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (begin == end)
+                {
+                    return false;
+                }
+                idx = begin++;
+                return true;
+            }
+        };
+
+        // Moves the back half of the largest other range into the (empty) range of the
+        // thief and returns false if no iterations are left
+        static bool steal(WorkRange * ranges, std::size_t rangeCount, std::size_t thiefIdx)
+        {
+            for (;;)
+            {
+                std::size_t victimIdx = rangeCount;
+                std::size_t maxRemainingCount = 0;
+                for (std::size_t i = 0; i < rangeCount; ++i)
+                {
+                    std::lock_guard<std::mutex> lock(ranges[i].mutex);
+                    if (i != thiefIdx && ranges[i].end - ranges[i].begin > maxRemainingCount)
+                    {
+                        victimIdx = i;
+                        maxRemainingCount = ranges[i].end - ranges[i].begin;
+                    }
+                }
+
+                if (victimIdx == rangeCount)
+                {
+                    return false;
+                }
+
+                std::size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> lock(ranges[victimIdx].mutex);
+                    auto && victim = ranges[victimIdx];
+                    if (victim.begin == victim.end)
+                    {
+                        continue; // emptied meanwhile; look again
+                    }
+                    end = victim.end;
+                    begin = victim.end - (victim.end - victim.begin + 1) / 2;
+                    victim.end = begin;
+                }
+
+                std::lock_guard<std::mutex> lock(ranges[thiefIdx].mutex);
+                ranges[thiefIdx].begin = begin;
+                ranges[thiefIdx].end = end;
+                return true;
+            }
+        }
+
+        void work()
+        {
+            for (;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_taskAvailable.wait(lock, [this] { return m_isStopping || !m_tasks.empty(); });
+                    if (m_tasks.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+    public:
+        // Constructor
+        //   threadCount is the total number of threads working on a loop, including the
+        //   caller of parallelFor() (0 uses the number of hardware threads)
+        explicit ThreadPool(std::size_t threadCount = 0) : m_isStopping(false)
+        {
+            if (threadCount == 0)
+            {
+                threadCount = std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            for (std::size_t i = 1; i < threadCount; ++i)
+            {
+                m_threads.emplace_back(&ThreadPool::work, this);
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool & operator= (const ThreadPool &) = delete;
+
+        // Destructor
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_isStopping = true;
+            }
+            m_taskAvailable.notify_all();
+
+            for (auto && thread : m_threads)
+            {
+                thread.join();
+            }
+        }
+
+        std::size_t threadCount() const noexcept
+        {
+            return m_threads.size() + 1;
+        }
+
+        // Calls f(i) for each i in [0, count) on the pool and waits for completion
+        //   The range is split evenly among the participating threads (the caller and up
+        //   to threadCount() - 1 workers). Each thread takes iterations from the front of
+        //   its own range; a thread whose range runs out steals the back half of the
+        //   largest remaining range, so uneven iterations (e.g. experiments converging at
+        //   different speeds) keep every thread busy while the common case touches only
+        //   the thread's own range. f may run concurrently with itself on different i.
+        //   The first exception thrown by f is rethrown here after all running
+        //   iterations have finished (iterations not yet started are skipped).
+        template <class Function>
+        void parallelFor(std::size_t count, Function f)
+        {
+            if (count == 0)
+            {
+                return;
+            }
+
+            std::size_t participantCount = std::min(m_threads.size() + 1, count);
+            std::unique_ptr<WorkRange[]> ranges(new WorkRange[participantCount]);
+            for (std::size_t i = 0; i < participantCount; ++i)
+            {
+                ranges[i].begin = count * i / participantCount;
+                ranges[i].end = count * (i + 1) / participantCount;
+            }
+
+            std::atomic<bool> isCancelled(false);
+            std::exception_ptr exception;
+            std::mutex exceptionMutex;
+
+            auto runIterations = [&](std::size_t participantIdx) {
+                auto && range = ranges[participantIdx];
+                while (!isCancelled)
+                {
+                    std::size_t i;
+                    if (!range.pop(i))
+                    {
+                        if (!steal(ranges.get(), participantCount, participantIdx))
+                        {
+                            return;
+                        }
+                        continue;
+                    }
+
+                    try
+                    {
+                        f(i);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(exceptionMutex);
+                        if (!exception)
+                        {
+                            exception = std::current_exception();
+                        }
+                        isCancelled = true;
+                    }
+                }
+            };
+
+            std::size_t helperCount = participantCount - 1;
+            std::size_t finishedHelperCount = 0;
+            std::mutex finishedMutex;
+            std::condition_variable finished;
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (std::size_t i = 1; i <= helperCount; ++i)
+                {
+                    m_tasks.emplace_back([&, i]() {
+                        runIterations(i);
+
+                        std::lock_guard<std::mutex> finishedLock(finishedMutex);
+                        ++finishedHelperCount;
+                        finished.notify_one();
+                    });
+                }
+            }
+            m_taskAvailable.notify_all();
+
+            runIterations(0);
+
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            finished.wait(lock, [&] { return finishedHelperCount == helperCount; });
+
+            if (exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+    };
+
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace XCS
+{
+
+    // Discrimination tree (ternary trie) match index for binary conditions
+    //   An internal node at depth i branches on allele i of the condition (0, 1 or
+    //   "don't care"). Conditions sharing a prefix share its path, so a query only
+    //   descends into the branches accepting the situation bit (the bit value and
+    //   "don't care") and skips every classifier that already failed on a prefix.
+    //   Leaves hold buckets of up to BucketSize classifiers whose remaining alleles are
+    //   tested with Condition::matches() (a leaf is split when its bucket overflows and
+    //   a subtree is collapsed back into a leaf when it shrinks to half a bucket), which
+    //   avoids walking long unshared paths one node per allele.
+    template <typename T, class Condition, class Classifier, std::size_t BucketSize = 16>
+    class TrieMatchIndex
+    {
+    protected:
+        using ClassifierPtr = std::shared_ptr<Classifier>;
+
+        static constexpr uint32_t noChild = 0;
+        static constexpr std::size_t dontCareBranch = 2;
+
+        struct Node
+        {
+            // Children for allele 0, 1 and "don't care" (noChild if absent)
+            uint32_t children[3] = { noChild, noChild, noChild };
+
+            // The number of classifiers stored under this node
+            std::size_t classifierCount = 0;
+
+            bool isLeaf = true;
+
+            // Classifiers (leaves only)
+            std::vector<ClassifierPtr> bucket;
+        };
+
+        // Condition length (set by the first insertion)
+        std::size_t m_length;
+
+        // m_nodes[0] is the root
+        std::vector<Node> m_nodes;
+        std::vector<uint32_t> m_freeNodes;
+
+        static std::size_t branch(const ClassifierPtr & cl, std::size_t depth)
+        {
+            auto && symbol = cl->condition.at(depth);
+            return symbol.isDontCare() ? dontCareBranch : (symbol.value() ? 1 : 0);
+        }
+
+        uint32_t newNode()
+        {
+            if (m_freeNodes.empty())
+            {
+                m_nodes.emplace_back();
+                return static_cast<uint32_t>(m_nodes.size() - 1);
+            }
+
+            uint32_t nodeIdx = m_freeNodes.back();
+            m_freeNodes.pop_back();
+            m_nodes[nodeIdx] = Node();
+            return nodeIdx;
+        }
+
+        // Adds cl to the leaf bucket of the subtree and splits the leaf if it overflows
+        void insertInto(uint32_t nodeIdx, std::size_t depth, const ClassifierPtr & cl)
+        {
+            while (!m_nodes[nodeIdx].isLeaf)
+            {
+                ++m_nodes[nodeIdx].classifierCount;
+
+                std::size_t b = branch(cl, depth);
+                if (m_nodes[nodeIdx].children[b] == noChild)
+                {
+                    uint32_t child = newNode(); // may reallocate m_nodes
+                    m_nodes[nodeIdx].children[b] = child;
+                }
+                nodeIdx = m_nodes[nodeIdx].children[b];
+                ++depth;
+            }
+
+            ++m_nodes[nodeIdx].classifierCount;
+            m_nodes[nodeIdx].bucket.push_back(cl);
+
+            if (m_nodes[nodeIdx].bucket.size() > BucketSize && depth < m_length)
+            {
+                std::vector<ClassifierPtr> bucket;
+                bucket.swap(m_nodes[nodeIdx].bucket);
+                m_nodes[nodeIdx].isLeaf = false;
+                m_nodes[nodeIdx].classifierCount = 0;
+
+                for (auto && c : bucket)
+                {
+                    insertInto(nodeIdx, depth, c);
+                }
+            }
+        }
+
+        // Moves all classifiers of the subtree into the given bucket and frees its nodes
+        void collect(uint32_t nodeIdx, std::vector<ClassifierPtr> & bucket)
+        {
+            Node & node = m_nodes[nodeIdx];
+
+            if (node.isLeaf)
+            {
+                bucket.insert(bucket.end(), node.bucket.begin(), node.bucket.end());
+                node.bucket.clear();
+                return;
+            }
+
+            for (auto && child : node.children)
+            {
+                if (child != noChild)
+                {
+                    collect(child, bucket);
+                    m_freeNodes.push_back(child);
+                    child = noChild;
+                }
+            }
+        }
+
+        template <class Situation, class Function>
+        void visit(uint32_t nodeIdx, std::size_t depth, const std::vector<T> & situation, const Situation & preparedSituation, Function & f) const
+        {
+            const Node & node = m_nodes[nodeIdx];
+
+            if (node.isLeaf)
+            {
+                for (auto && cl : node.bucket)
+                {
+                    if (cl->condition.matches(preparedSituation))
+                    {
+                        f(cl);
+                    }
+                }
+                return;
+            }
+
+            uint32_t child = node.children[situation[depth] ? 1 : 0];
+            if (child != noChild)
+            {
+                visit(child, depth + 1, situation, preparedSituation, f);
+            }
+
+            child = node.children[dontCareBranch];
+            if (child != noChild)
+            {
+                visit(child, depth + 1, situation, preparedSituation, f);
+            }
+        }
+
+    public:
+        // Constructor
+        TrieMatchIndex() : m_length(0), m_nodes(1) {}
+
+        template <class Constants>
+        explicit TrieMatchIndex(const Constants &) : TrieMatchIndex() {}
+
+        // Destructor
+        virtual ~TrieMatchIndex() = default;
+
+        void insert(const ClassifierPtr & cl)
+        {
+            if (m_nodes[0].classifierCount == 0 && m_length != cl->condition.size())
+            {
+                clear();
+                m_length = cl->condition.size();
+            }
+
+            assert(m_length == cl->condition.size());
+
+            insertInto(0, 0, cl);
+        }
+
+        void erase(const ClassifierPtr & cl)
+        {
+            if (m_length != cl->condition.size())
+            {
+                return;
+            }
+
+            // Find the path to the leaf
+            std::vector<uint32_t> path(1, 0);
+            while (!m_nodes[path.back()].isLeaf)
+            {
+                uint32_t child = m_nodes[path.back()].children[branch(cl, path.size() - 1)];
+                if (child == noChild)
+                {
+                    return;
+                }
+                path.push_back(child);
+            }
+
+            auto && bucket = m_nodes[path.back()].bucket;
+            auto it = std::find(bucket.begin(), bucket.end(), cl);
+            if (it == bucket.end())
+            {
+                return;
+            }
+            *it = bucket.back();
+            bucket.pop_back();
+
+            for (auto && nodeIdx : path)
+            {
+                --m_nodes[nodeIdx].classifierCount;
+            }
+
+            // Collapse the highest subtree on the path that shrank to half a bucket
+            for (std::size_t i = 0; i < path.size(); ++i)
+            {
+                Node & node = m_nodes[path[i]];
+                if (node.classifierCount == 0 && i > 0)
+                {
+                    m_nodes[path[i - 1]].children[branch(cl, i - 1)] = noChild;
+                    std::vector<ClassifierPtr> bucket;
+                    collect(path[i], bucket);
+                    m_freeNodes.push_back(path[i]);
+                    break;
+                }
+                if (!node.isLeaf && node.classifierCount <= BucketSize / 2)
+                {
+                    std::vector<ClassifierPtr> bucket;
+                    collect(path[i], bucket);
+                    m_nodes[path[i]].isLeaf = true;
+                    m_nodes[path[i]].bucket.swap(bucket);
+                    break;
+                }
+            }
+        }
+
+        void clear()
+        {
+            m_nodes.assign(1, Node());
+            m_freeNodes.clear();
+        }
+
+        // The number of nodes in use (including the root)
+        std::size_t nodeCount() const
+        {
+            return m_nodes.size() - m_freeNodes.size();
+        }
+
+        // Calls f for each indexed classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            if (m_nodes[0].classifierCount == 0)
+            {
+                return;
+            }
+
+            assert(m_length == situation.size());
+
+            auto && preparedSituation = Condition::prepareSituation(situation);
+            visit(0, 0, situation, preparedSituation, f);
+        }
+    };
+
+}
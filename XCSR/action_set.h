@@ -13,6 +13,7 @@ namespace XCSR
         using XCS::ActionSet<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA>::m_set;
         using XCS::ActionSet<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA>::m_constants;
         using XCS::ActionSet<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA>::m_availableActions;
+        using XCS::ActionSet<T, Action, Symbol, Condition, Classifier, Constants, ClassifierPtrSet, Population, MatchSet, GA>::eraseAt;
 
         // DO ACTION SET SUBSUMPTION
         virtual void doSubsumption(Population & population) override
@@ -32,21 +33,22 @@ namespace XCSR
 
             if (cl.get() != nullptr)
             {
-                std::vector<const ClassifierPtr *> removedClassifiers;
-                for (auto && c : m_set)
+                for (std::size_t i = 0; i < m_set.size(); )
                 {
-                    if (cl->isMoreGeneral(*c))
+                    if (cl->isMoreGeneral(*m_set[i]))
                     {
-                        cl->numerosity += c->numerosity;
-                        removedClassifiers.push_back(&c);
+                        XCS_PROFILE_COUNT(Subsumption);
+                        cl->numerosity += m_set[i]->numerosity;
+                        population.erase(m_set[i]);
+                        eraseAt(i);
+                    }
+                    else
+                    {
+                        ++i;
                     }
                 }
 
-                for (auto && removedClassifier : removedClassifiers)
-                {
-                    population.erase(*removedClassifier);
-                    m_set.erase(*removedClassifier);
-                }
+                population.updateDeletionVote(cl);
             }
         }
 
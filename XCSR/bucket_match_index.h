@@ -0,0 +1,234 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+#include "../XCS/bits.h"
+#include "../XCS/flat_index.h"
+
+namespace XCSR
+{
+
+    // Per-dimension bucketed bitmap match index for XCSR conditions
+    //   Each dimension is quantized into BucketCount buckets over [minValue, maxValue]
+    //   (values outside the range fall into the first or the last bucket). For each
+    //   dimension and bucket the index keeps two bitsets over classifier slots: the
+    //   classifiers whose interval overlaps the bucket, and those whose interval covers
+    //   the whole bucket. A query ANDs one bitset of each kind per dimension. Slots in
+    //   every "covers" bitset match without further tests, and only the remaining
+    //   candidates (whose interval edges fall in a hit bucket) have their bounds checked.
+    template <typename T, class Condition, class Classifier, std::size_t BucketCount = 16>
+    class BucketMatchIndex
+    {
+    protected:
+        using ClassifierPtr = std::shared_ptr<Classifier>;
+
+        const T m_minValue;
+        const T m_bucketWidth;
+
+        // Dimension (set by the first insertion)
+        std::size_t m_dimension;
+
+        // m_bits[((w * m_dimension + d) * BucketCount + b) * 2 + k] for overlaps (k = 0) and covers (k = 1)
+        std::vector<uint64_t> m_bits;
+
+        // Occupied slots for each block
+        std::vector<uint64_t> m_occupied;
+
+        // Bounds (center - spread and center + spread) of each slot
+        std::vector<T> m_lower;
+        std::vector<T> m_upper;
+
+        std::vector<ClassifierPtr> m_slots;
+        std::vector<std::size_t> m_freeSlots;
+        XCS::FlatIndex<const Classifier *> m_slotIdxs;
+
+        std::size_t blockSize() const
+        {
+            return m_dimension * BucketCount * 2;
+        }
+
+        // Monotonic in value, so lower <= value < upper implies bucket(lower) <= bucket(value) <= bucket(upper)
+        std::size_t bucket(T value) const
+        {
+            T position = std::floor((value - m_minValue) / m_bucketWidth);
+            if (!(position > 0))
+            {
+                return 0;
+            }
+            if (position >= static_cast<T>(BucketCount - 1))
+            {
+                return BucketCount - 1;
+            }
+            return static_cast<std::size_t>(position);
+        }
+
+        void setSlotBits(std::size_t slotIdx, bool value)
+        {
+            uint64_t mask = uint64_t(1) << (slotIdx % XCS::Bits::wordBitLength);
+            uint64_t * bits = &m_bits[slotIdx / XCS::Bits::wordBitLength * blockSize()];
+
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                std::size_t lowerBucket = bucket(m_lower[slotIdx * m_dimension + d]);
+                std::size_t upperBucket = bucket(m_upper[slotIdx * m_dimension + d]);
+
+                for (std::size_t b = lowerBucket; b <= upperBucket; ++b)
+                {
+                    uint64_t * bucketBits = &bits[(d * BucketCount + b) * 2];
+
+                    bucketBits[0] = value ? (bucketBits[0] | mask) : (bucketBits[0] & ~mask);
+
+                    // The interval contains every value of the buckets strictly between its edge buckets
+                    if (lowerBucket < b && b < upperBucket)
+                    {
+                        bucketBits[1] = value ? (bucketBits[1] | mask) : (bucketBits[1] & ~mask);
+                    }
+                }
+            }
+        }
+
+    public:
+        // Constructor
+        template <class Constants>
+        explicit BucketMatchIndex(const Constants & constants) :
+            m_minValue(constants.minValue),
+            m_bucketWidth((constants.maxValue - constants.minValue) / BucketCount),
+            m_dimension(0)
+        {
+            assert(m_bucketWidth > 0);
+        }
+
+        // Destructor
+        virtual ~BucketMatchIndex() = default;
+
+        void insert(const ClassifierPtr & cl)
+        {
+            assert(m_slotIdxs.find(cl.get()) == XCS::FlatIndex<const Classifier *>::npos);
+
+            if (m_slotIdxs.empty() && m_dimension != cl->condition.size())
+            {
+                clear();
+                m_dimension = cl->condition.size();
+            }
+
+            assert(m_dimension == cl->condition.size());
+
+            std::size_t slotIdx;
+            if (m_freeSlots.empty())
+            {
+                slotIdx = m_slots.size();
+                m_slots.emplace_back();
+                m_lower.resize(m_slots.size() * m_dimension);
+                m_upper.resize(m_slots.size() * m_dimension);
+                if (slotIdx % XCS::Bits::wordBitLength == 0)
+                {
+                    m_bits.resize(m_bits.size() + blockSize(), 0);
+                    m_occupied.push_back(0);
+                }
+            }
+            else
+            {
+                slotIdx = m_freeSlots.back();
+                m_freeSlots.pop_back();
+            }
+
+            m_slots[slotIdx] = cl;
+            m_slotIdxs.insert(cl.get(), slotIdx);
+
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                auto && symbol = cl->condition.at(d);
+                m_lower[slotIdx * m_dimension + d] = symbol.center - symbol.spread;
+                m_upper[slotIdx * m_dimension + d] = symbol.center + symbol.spread;
+            }
+
+            setSlotBits(slotIdx, true);
+            m_occupied[slotIdx / XCS::Bits::wordBitLength] |= uint64_t(1) << (slotIdx % XCS::Bits::wordBitLength);
+        }
+
+        void erase(const ClassifierPtr & cl)
+        {
+            std::size_t slotIdx = m_slotIdxs.find(cl.get());
+            if (slotIdx == XCS::FlatIndex<const Classifier *>::npos)
+            {
+                return;
+            }
+
+            m_slotIdxs.erase(cl.get(), slotIdx);
+
+            setSlotBits(slotIdx, false);
+            m_occupied[slotIdx / XCS::Bits::wordBitLength] &= ~(uint64_t(1) << (slotIdx % XCS::Bits::wordBitLength));
+
+            m_slots[slotIdx].reset();
+            m_freeSlots.push_back(slotIdx);
+        }
+
+        void clear()
+        {
+            m_bits.clear();
+            m_occupied.clear();
+            m_lower.clear();
+            m_upper.clear();
+            m_slots.clear();
+            m_freeSlots.clear();
+            m_slotIdxs.clear();
+        }
+
+        // Calls f for each indexed classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            assert(m_slotIdxs.empty() || m_dimension == situation.size());
+
+            // Offsets of the hit bucket of each dimension inside a block
+            std::vector<std::size_t> offsets(m_dimension);
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                offsets[d] = (d * BucketCount + bucket(situation[d])) * 2;
+            }
+
+            const uint64_t * bits = m_bits.data();
+            for (std::size_t w = 0; w < m_occupied.size(); ++w, bits += blockSize())
+            {
+                uint64_t candidates = m_occupied[w];
+                uint64_t matches = m_occupied[w];
+                for (std::size_t d = 0; d < m_dimension && candidates != 0; ++d)
+                {
+                    candidates &= bits[offsets[d]];
+                    matches &= bits[offsets[d] + 1];
+                }
+
+                while (candidates != 0)
+                {
+                    std::size_t slotIdx = w * XCS::Bits::wordBitLength + XCS::Bits::countTrailingZeros(candidates);
+                    uint64_t mask = candidates & (~candidates + 1);
+                    candidates &= candidates - 1;
+
+                    if ((matches & mask) == 0)
+                    {
+                        // Check the bounds of the candidate
+                        const T * lower = &m_lower[slotIdx * m_dimension];
+                        const T * upper = &m_upper[slotIdx * m_dimension];
+                        std::size_t d = 0;
+                        while (d < m_dimension && lower[d] <= situation[d] && situation[d] < upper[d])
+                        {
+                            ++d;
+                        }
+                        if (d < m_dimension)
+                        {
+                            continue;
+                        }
+                    }
+
+                    f(m_slots[slotIdx]);
+                }
+            }
+        }
+    };
+
+}
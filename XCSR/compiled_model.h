@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstddef>
+#include <cassert>
+
+#include "../XCS/compiled_model.h"
+
+namespace XCSR
+{
+
+    // Compiled model of an XCSR population (conditions as interval bounds)
+    template <typename T = double, typename Action = bool>
+    class CompiledModel : public XCS::AbstractCompiledModel<Action, double>
+    {
+    private:
+        using XCS::AbstractCompiledModel<Action, double>::m_header;
+        using XCS::AbstractCompiledModel<Action, double>::m_actions;
+        using XCS::AbstractCompiledModel<Action, double>::situationBlockSize;
+        using XCS::AbstractCompiledModel<Action, double>::accumulateBlock;
+
+    public:
+        // Constructor
+        explicit CompiledModel(const std::string & filename) :
+            XCS::AbstractCompiledModel<Action, double>(filename, XCS::CompiledConditionKind::Interval)
+        {
+        }
+
+        // Compiles the population of an XCSR into a model file
+        //   A symbol (center, spread) becomes the interval [center - spread, center + spread),
+        //   as in Symbol::matches(). sortsByNumerosity puts the most numerous classifiers
+        //   of each action first.
+        template <class Population>
+        static void compile(const Population & population, const std::string & filename, bool sortsByNumerosity = false)
+        {
+            auto && actionIndex = population.actionIndex();
+
+            std::size_t situationLength = population.size() > 0 ? (*population.begin())->condition.size() : 0;
+
+            std::vector<XCS::CompiledClassifier<double>> classifiers;
+            for (auto && cl : population)
+            {
+                assert(cl->condition.size() == situationLength);
+
+                XCS::CompiledClassifier<double> compiledClassifier = { actionIndex.idx(cl->action), cl->numerosity, { cl->prediction, cl->fitness }, std::vector<double>(situationLength * 2) };
+                for (std::size_t i = 0; i < situationLength; ++i)
+                {
+                    auto && symbol = cl->condition.at(i);
+                    compiledClassifier.condition[i] = symbol.center - symbol.spread;
+                    compiledClassifier.condition[situationLength + i] = symbol.center + symbol.spread;
+                }
+                classifiers.push_back(std::move(compiledClassifier));
+            }
+
+            XCS::writeCompiledModel(filename, XCS::CompiledConditionKind::Interval, situationLength, situationLength * 2, actionIndex.actions(), std::move(classifiers), sortsByNumerosity);
+        }
+
+        // Returns the action with the highest prediction for each situation and stores
+        // the prediction arrays in predictionArrays[situationIdx * actions().size() + i]
+        // (same selection as Experiment::predict(), with ties broken at random with random)
+        //   Throws std::invalid_argument if a situation is not of situationLength().
+        std::vector<Action> predict(const std::vector<std::vector<T>> & situations, std::vector<double> & predictionArrays, XCS::RandomEngine & random) const
+        {
+            std::size_t situationLength = m_header->situationLength;
+
+            std::vector<XCS::PredictionArraySums> sums(situations.size() * m_actions.size(), XCS::PredictionArraySums{ 0.0, 0.0, false });
+            std::vector<double> block;
+            for (std::size_t begin = 0; begin < situations.size(); begin += situationBlockSize)
+            {
+                std::size_t blockSize = std::min(situationBlockSize, situations.size() - begin);
+
+                block.clear();
+                for (std::size_t i = begin; i < begin + blockSize; ++i)
+                {
+                    if (situations[i].size() != situationLength)
+                    {
+                        throw std::invalid_argument("Expected situations of length " + std::to_string(situationLength));
+                    }
+                    block.insert(block.end(), situations[i].begin(), situations[i].end());
+                }
+
+                accumulateBlock(begin, blockSize, [&](const double * condition, std::size_t blockIdx) {
+                    const double * situation = block.data() + blockIdx * situationLength;
+                    for (std::size_t i = 0; i < situationLength; ++i)
+                    {
+                        if (!(condition[i] <= situation[i] && situation[i] < condition[situationLength + i]))
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }, sums);
+            }
+
+            return XCS::selectGreedyActions(m_actions, sums, predictionArrays, random);
+        }
+
+        std::vector<Action> predict(const std::vector<std::vector<T>> & situations, XCS::RandomEngine & random) const
+        {
+            std::vector<double> predictionArrays;
+            return predict(situations, predictionArrays, random);
+        }
+
+        Action predict(const std::vector<T> & situation, XCS::RandomEngine & random) const
+        {
+            return predict(std::vector<std::vector<T>>{ situation }, random)[0];
+        }
+    };
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "../XCS/constants.h"
 
 namespace XCSR
@@ -19,6 +21,15 @@ namespace XCSR
 
         // Destructor
         virtual ~Constants() = default;
+
+        virtual bool set(const std::string & name, const std::string & value) override
+        {
+            return assignIfNamed(name, value, "minValue", minValue)
+                || assignIfNamed(name, value, "maxValue", maxValue)
+                || assignIfNamed(name, value, "maxSpread", maxSpread)
+                || assignIfNamed(name, value, "mutationMaxChange", mutationMaxChange)
+                || XCS::Constants::set(name, value);
+        }
     };
 
 }
\ No newline at end of file
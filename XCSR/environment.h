@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <stdexcept>
 #include <cassert>
 
 #include "../XCS/environment.h"
@@ -76,6 +78,28 @@ namespace XCSR
             return m_isEndOfProblem;
         }
 
+        virtual std::shared_ptr<XCS::AbstractEnvironment<double, bool, Symbol<double>>> clone() const override
+        {
+            return std::make_shared<RealMultiplexerEnvironment>(*this);
+        }
+
+        virtual void writeState(XCS::BinaryWriter & writer) const override
+        {
+            writer.writeVector(m_situation);
+            writer.write(m_isEndOfProblem);
+        }
+
+        virtual void readState(XCS::BinaryReader & reader) override
+        {
+            reader.readVector(m_situation);
+            reader.read(m_isEndOfProblem);
+
+            if (m_situation.size() != m_totalLength)
+            {
+                throw std::runtime_error("Invalid multiplexer state");
+            }
+        }
+
         // Returns the answer
         virtual bool getAnswer(const std::vector<double> & situation) const
         {
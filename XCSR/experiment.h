@@ -3,6 +3,7 @@
 #include "../XCS/experiment.h"
 #include "../XCS/condition.h"
 #include "symbol.h"
+#include "interval_condition.h"
 #include "classifier.h"
 #include "constants.h"
 #include "match_set.h"
@@ -17,7 +18,7 @@ namespace XCSR
         typename T,
         typename Action,
         class Symbol = Symbol<T>,
-        class Condition = XCS::Condition<T, Symbol>,
+        class Condition = IntervalCondition<T, Symbol>,
         class ConditionActionPair = ConditionActionPair<T, Action, Symbol, Condition>,
         class Constants = Constants,
         class Classifier = XCS::Classifier<T, Action, Symbol, Condition, ConditionActionPair, Constants>,
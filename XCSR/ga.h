@@ -13,33 +13,42 @@ namespace XCSR
     protected:
         using XCS::GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::m_constants;
         using XCS::GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::m_availableActions;
+        using XCS::GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::chooseOtherAction;
+
+        // APPLY CROSSOVER
+        virtual void crossover(Classifier & cl1, Classifier & cl2) const override
+        {
+            XCS::GA<T, Action, Symbol, Condition, Classifier, Population, Constants, ClassifierPtrSet>::crossover(cl1, cl2);
+
+            cl1.condition.refresh();
+            cl2.condition.refresh();
+        }
 
         // APPLY MUTATION
         virtual void mutate(Classifier & cl, const std::vector<T> & situation) const override
         {
             assert(cl.condition.size() == situation.size());
 
-            // Mutate center and spread individually
-            for (std::size_t i = 0; i < cl.condition.size(); ++i)
-            {
-                if (XCS::Random::nextDouble() < m_constants.mutationProbability)
+            // Mutate center and spread individually (trial 2i is the center of allele i
+            // and trial 2i + 1 its spread)
+            XCS::Random::forEachBernoulliSuccess(cl.condition.size() * 2, m_constants.mutationProbability, [&](std::size_t trialIdx) {
+                std::size_t i = trialIdx / 2;
+                if (trialIdx % 2 == 0)
                 {
                     cl.condition[i].center += XCS::Random::nextDouble(-m_constants.mutationMaxChange, m_constants.mutationMaxChange);
                     cl.condition[i].center = std::min(std::max(m_constants.minValue, cl.condition[i].center), m_constants.maxValue);
                 }
-
-                if (XCS::Random::nextDouble() < m_constants.mutationProbability)
+                else
                 {
                     cl.condition[i].spread += XCS::Random::nextDouble(-m_constants.mutationMaxChange, m_constants.mutationMaxChange);
                     cl.condition[i].spread = std::min(std::max(0.0, cl.condition[i].spread), m_constants.maxSpread);
                 }
-            }
+            });
+            cl.condition.refresh();
 
             if ((XCS::Random::nextDouble() < m_constants.mutationProbability) && (m_availableActions.size() >= 2))
             {
-                std::unordered_set<Action> otherPossibleActions(m_availableActions);
-                otherPossibleActions.erase(cl.action);
-                cl.action = XCS::Random::chooseFrom(otherPossibleActions);
+                cl.action = chooseOtherAction(cl.action);
             }
         }
 
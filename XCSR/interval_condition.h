@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+#include "../XCS/condition.h"
+#include "../XCS/aligned_allocator.h"
+#include "interval_kernel.h"
+
+namespace XCSR
+{
+
+    // The condition for XCSR keeping the interval bounds of its symbols in aligned arrays
+    //   matches() tests all dimensions with the vector kernel selected for the running
+    //   CPU instead of calling Symbol::matches() allele by allele. The bounds are derived
+    //   from the symbols. After modifying the symbols through the non-const operator[]
+    //   (as the GA does on offspring), call refresh() to recompute them; matches() only
+    //   reads them, so conditions in the population may be matched on several threads.
+    template <typename T, class Symbol>
+    class IntervalCondition : public XCS::Condition<T, Symbol>
+    {
+    protected:
+        using Array = std::vector<T, XCS::AlignedAllocator<T, intervalKernelAlignment>>;
+        using XCS::Condition<T, Symbol>::m_symbols;
+
+        // Lower (center - spread) and upper (center + spread) bounds padded to the lane count
+        Array m_lower;
+        Array m_upper;
+        bool m_isOutdated; // symbols modified since the bounds were computed
+
+        static std::size_t paddedSize(std::size_t size)
+        {
+            return (size + intervalKernelLaneCount - 1) / intervalKernelLaneCount * intervalKernelLaneCount;
+        }
+
+        void updateBounds()
+        {
+            std::size_t size = paddedSize(m_symbols.size());
+            m_lower.assign(size, -std::numeric_limits<T>::infinity());
+            m_upper.assign(size, std::numeric_limits<T>::infinity());
+
+            for (std::size_t i = 0; i < m_symbols.size(); ++i)
+            {
+                m_lower[i] = m_symbols[i].center - m_symbols[i].spread;
+                m_upper[i] = m_symbols[i].center + m_symbols[i].spread;
+            }
+
+            m_isOutdated = false;
+        }
+
+    public:
+        // The aligned and padded form of a situation accepted by matches()
+        using Situation = Array;
+
+        // Constructor
+        IntervalCondition() : m_isOutdated(false) {}
+
+        IntervalCondition(const std::vector<Symbol> & symbols) : XCS::Condition<T, Symbol>(symbols)
+        {
+            updateBounds();
+        }
+
+        IntervalCondition(const std::vector<T> & symbols) : XCS::Condition<T, Symbol>(symbols)
+        {
+            updateBounds();
+        }
+
+        IntervalCondition(const IntervalCondition & obj) :
+            XCS::Condition<T, Symbol>(obj),
+            m_lower(obj.m_lower),
+            m_upper(obj.m_upper),
+            m_isOutdated(obj.m_isOutdated)
+        {
+            if (m_isOutdated)
+            {
+                updateBounds();
+            }
+        }
+
+        IntervalCondition & operator= (const IntervalCondition & obj)
+        {
+            XCS::Condition<T, Symbol>::operator=(obj);
+            m_lower = obj.m_lower;
+            m_upper = obj.m_upper;
+            m_isOutdated = obj.m_isOutdated;
+            if (m_isOutdated)
+            {
+                updateBounds();
+            }
+            return *this;
+        }
+
+        // Destructor
+        virtual ~IntervalCondition() = default;
+
+        // Copies a situation into an aligned array padded to the lane count
+        static Situation prepareSituation(const std::vector<T> & situation)
+        {
+            Situation prepared(paddedSize(situation.size()), T());
+            std::copy(situation.begin(), situation.end(), prepared.begin());
+            return prepared;
+        }
+
+        virtual Symbol & operator[] (std::size_t idx) override
+        {
+            m_isOutdated = true;
+            return m_symbols[idx];
+        }
+
+        // Recomputes the bounds if the symbols were modified through operator[]
+        virtual void refresh() override
+        {
+            if (m_isOutdated)
+            {
+                updateBounds();
+            }
+        }
+
+        virtual void randomGeneralize(double generalizeProbability) override
+        {
+            XCS::Condition<T, Symbol>::randomGeneralize(generalizeProbability);
+            updateBounds();
+        }
+
+        // DOES MATCH
+        bool matches(const Situation & situation) const
+        {
+            assert(paddedSize(m_symbols.size()) == situation.size());
+            assert(!m_isOutdated);
+
+            return IntervalKernel<T>::matches(m_lower.data(), m_upper.data(), situation.data(), situation.size());
+        }
+
+        virtual bool matches(const std::vector<T> & situation) const override
+        {
+            assert(m_symbols.size() == situation.size());
+
+            return matches(prepareSituation(situation));
+        }
+
+        virtual void read(XCS::BinaryReader & reader) override
+        {
+            XCS::Condition<T, Symbol>::read(reader);
+            updateBounds();
+        }
+    };
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define XCSR_INTERVAL_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(XCSR_INTERVAL_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define XCSR_TARGET_AVX __attribute__((target("avx")))
+#define XCSR_TARGET_SSE2 __attribute__((target("sse2")))
+#else
+#define XCSR_TARGET_AVX
+#define XCSR_TARGET_SSE2
+#endif
+
+namespace XCSR
+{
+
+    // Kernels testing lower[i] <= situation[i] < upper[i] for all i
+    //   The arrays hold paddedSize elements, where paddedSize is a multiple of
+    //   intervalKernelLaneCount and the padding lanes always pass. All arrays must be
+    //   aligned to intervalKernelAlignment bytes.
+    constexpr std::size_t intervalKernelLaneCount = 4;
+    constexpr std::size_t intervalKernelAlignment = 32;
+
+    template <typename T>
+    struct IntervalKernel
+    {
+        static bool matches(const T * lower, const T * upper, const T * situation, std::size_t paddedSize)
+        {
+            for (std::size_t i = 0; i < paddedSize; ++i)
+            {
+                if (!(lower[i] <= situation[i] && situation[i] < upper[i]))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    template <>
+    struct IntervalKernel<double>
+    {
+        using Function = bool (*)(const double *, const double *, const double *, std::size_t);
+
+        static bool matchesScalar(const double * lower, const double * upper, const double * situation, std::size_t paddedSize)
+        {
+            // Check a block of lanes at a time to return early like the vector versions
+            for (std::size_t i = 0; i < paddedSize; i += intervalKernelLaneCount)
+            {
+                bool result = true;
+                for (std::size_t j = i; j < i + intervalKernelLaneCount; ++j)
+                {
+                    result &= (lower[j] <= situation[j]) & (situation[j] < upper[j]);
+                }
+
+                if (!result)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+#if defined(XCSR_INTERVAL_KERNEL_X86)
+        XCSR_TARGET_SSE2 static bool matchesSSE2(const double * lower, const double * upper, const double * situation, std::size_t paddedSize)
+        {
+            for (std::size_t i = 0; i < paddedSize; i += 4)
+            {
+                __m128d v0 = _mm_load_pd(situation + i);
+                __m128d v1 = _mm_load_pd(situation + i + 2);
+                __m128d ok0 = _mm_and_pd(_mm_cmple_pd(_mm_load_pd(lower + i), v0), _mm_cmplt_pd(v0, _mm_load_pd(upper + i)));
+                __m128d ok1 = _mm_and_pd(_mm_cmple_pd(_mm_load_pd(lower + i + 2), v1), _mm_cmplt_pd(v1, _mm_load_pd(upper + i + 2)));
+
+                if (_mm_movemask_pd(_mm_and_pd(ok0, ok1)) != 0x3)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        XCSR_TARGET_AVX static bool matchesAVX(const double * lower, const double * upper, const double * situation, std::size_t paddedSize)
+        {
+            for (std::size_t i = 0; i < paddedSize; i += 4)
+            {
+                __m256d v = _mm256_load_pd(situation + i);
+                __m256d ok = _mm256_and_pd(
+                    _mm256_cmp_pd(_mm256_load_pd(lower + i), v, _CMP_LE_OQ),
+                    _mm256_cmp_pd(v, _mm256_load_pd(upper + i), _CMP_LT_OQ));
+
+                if (_mm256_movemask_pd(ok) != 0xF)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        static bool supportsSSE2()
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+
+        static bool supportsAVX()
+        {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            bool osUsesXSave = (info[2] & (1 << 27)) != 0;
+            bool cpuSupportsAVX = (info[2] & (1 << 28)) != 0;
+            return osUsesXSave && cpuSupportsAVX && ((_xgetbv(0) & 0x6) == 0x6);
+#else
+            return __builtin_cpu_supports("avx");
+#endif
+        }
+#endif
+
+        // Selects the fastest kernel supported by the running CPU
+        static Function select()
+        {
+#if defined(XCSR_INTERVAL_KERNEL_X86)
+            if (supportsAVX())
+            {
+                return &matchesAVX;
+            }
+            if (supportsSSE2())
+            {
+                return &matchesSSE2;
+            }
+#endif
+            return &matchesScalar;
+        }
+
+        static bool matches(const double * lower, const double * upper, const double * situation, std::size_t paddedSize)
+        {
+            static const Function function = select();
+            return function(lower, upper, situation, paddedSize);
+        }
+    };
+
+}
@@ -1,46 +1,66 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <cstddef>
 
 #include "experiment.h"
+#include "../XCS/experiment_runner.h"
+#include "../XCS/multiplexer_sweep.h"
 
 using namespace XCSR;
 
-int main()
+// The constants shared by every multiplexer length
+Constants baseConstants()
 {
-    std::size_t multiplexerLength = 6;
-
     Constants constants;
-
     constants.thetaGA = 12;
+    return constants;
+}
 
-    if (multiplexerLength == 3)
-    {
-        constants.maxPopulationClassifierCount = 200;
-    }
-    else if (multiplexerLength == 6)
-    {
-        constants.maxPopulationClassifierCount = 400;
-    }
-    else if (multiplexerLength == 11)
-    {
-        constants.maxPopulationClassifierCount = 800;
-    }
-    else if (multiplexerLength == 20)
-    {
-        constants.maxPopulationClassifierCount = 2000;
-    }
-    else if (multiplexerLength == 37)
+// The environment of the experiments
+std::shared_ptr<RealMultiplexerEnvironment> makeEnvironment(std::size_t multiplexerLength)
+{
+    return std::make_shared<RealMultiplexerEnvironment>(multiplexerLength, true);
+}
+
+// Usage: xcsr [sweep config file]
+//   Without arguments, runs the experiment below (the learning curve of one run, or
+//   the average of repetitionCount runs); with a config file, runs a parameter sweep.
+int main(int argc, char * argv[])
+{
+    if (argc > 1)
     {
-        constants.maxPopulationClassifierCount = 5000;
+        return XCS::runMultiplexerSweep<Experiment<double, bool>>(argv[1], baseConstants(), 6, makeEnvironment);
     }
-    else
+
+    std::size_t multiplexerLength = 6;
+
+    // The number of independent runs averaged into one learning curve
+    std::size_t repetitionCount = 1;
+
+    Constants constants = XCS::multiplexerConstants(baseConstants(), multiplexerLength);
+
+    if (repetitionCount > 1)
     {
-        constants.maxPopulationClassifierCount = 50000;
+        std::vector<uint64_t> seeds;
+        for (std::size_t i = 0; i < repetitionCount; ++i)
+        {
+            seeds.push_back(XCS::Random::nondeterministicSeed());
+        }
+
+        XCS::ExperimentRunner runner;
+        auto collector = runner.run([&](std::size_t, uint64_t) {
+            return std::make_unique<Experiment<double, bool>>(makeEnvironment(multiplexerLength), constants);
+        }, seeds, XCS::ExperimentSchedule());
+        collector.writeLearningCurve(std::cout);
+
+        return 0;
     }
 
-    Experiment<double, bool> xcsr(std::make_shared<RealMultiplexerEnvironment>(multiplexerLength, true), constants);
+    Experiment<double, bool> xcsr(makeEnvironment(multiplexerLength), constants);
+    xcsr.setEvaluationThreadCount(0);
     for (std::size_t i = 0; i < 500; ++i)
     {
         xcsr.run(100);
@@ -15,7 +15,7 @@ namespace XCSR
         using ClassifierPtrSet::m_availableActions;
 
         // GENERATE COVERING CLASSIFIER
-        virtual ClassifierPtr generateCoveringClassifier(const std::vector<T> & situation, const std::unordered_set<Action> & unselectedActions, uint64_t timeStamp) const override
+        virtual ClassifierPtr generateCoveringClassifier(const Population & population, const std::vector<T> & situation, Action action, uint64_t timeStamp) const override
         {
             std::vector<Symbol> symbols;
             for (auto && symbol : situation)
@@ -23,7 +23,7 @@ namespace XCSR
                 symbols.emplace_back(symbol, XCS::Random::nextDouble(0.0, m_constants.maxSpread));
             }
 
-            return std::make_shared<Classifier>(symbols, XCS::Random::chooseFrom(unselectedActions), timeStamp, m_constants);
+            return population.makeClassifier(symbols, action, timeStamp, m_constants);
         }
 
     public:
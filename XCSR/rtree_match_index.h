@@ -0,0 +1,347 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace XCSR
+{
+
+    // R-tree match index over the hyperrectangles of XCSR conditions
+    //   Each classifier is the box [center - spread, center + spread) in every dimension,
+    //   and matching a situation is a point-stabbing query. The tree is bulk-loaded with
+    //   Sort-Tile-Recursive packing (full nodes of NodeCapacity entries, contiguous in
+    //   memory). Classifiers inserted after the last build are kept in an unindexed
+    //   buffer that queries scan linearly, and removed ones are left as tombstones in the
+    //   tree. The tree is rebuilt when the buffer and tombstones together exceed
+    //   RebuildPercentage percent of the tree, so updates stay amortized O(log N) while
+    //   the GA keeps inserting and deleting classifiers.
+    template <typename T, class Condition, class Classifier, std::size_t NodeCapacity = 16, std::size_t RebuildPercentage = 25>
+    class RTreeMatchIndex
+    {
+    protected:
+        using ClassifierPtr = std::shared_ptr<Classifier>;
+
+        static constexpr std::size_t minRebuildCount = 64;
+
+        struct Node
+        {
+            // Range of children (internal nodes) or entries (leaves)
+            std::size_t begin;
+            std::size_t end;
+            bool isLeaf;
+        };
+
+        // Dimension (set by the first insertion)
+        std::size_t m_dimension;
+
+        // Tree entries (nullptr for tombstones) and their boxes (m_dimension values each)
+        std::vector<ClassifierPtr> m_entries;
+        std::vector<T> m_entryLower;
+        std::vector<T> m_entryUpper;
+        std::size_t m_tombstoneCount;
+
+        // Nodes (the root is the last one) and their bounding boxes
+        std::vector<Node> m_nodes;
+        std::vector<T> m_nodeLower;
+        std::vector<T> m_nodeUpper;
+
+        // Classifiers inserted since the last build
+        std::vector<ClassifierPtr> m_buffer;
+
+        // Position of each classifier (entry index, or bufferPosition() of its buffer index)
+        std::unordered_map<const Classifier *, std::size_t> m_positions;
+
+        std::size_t bufferPosition(std::size_t bufferIdx) const
+        {
+            return std::numeric_limits<std::size_t>::max() / 2 + bufferIdx;
+        }
+
+        bool isBufferPosition(std::size_t position) const
+        {
+            return position >= std::numeric_limits<std::size_t>::max() / 2;
+        }
+
+        // Sorts the entries [begin, end) by the box center in the given dimension and
+        // tiles them into slabs recursively (Sort-Tile-Recursive)
+        void tile(std::vector<std::size_t> & order, std::size_t begin, std::size_t end, std::size_t dim, const std::vector<ClassifierPtr> & classifiers) const
+        {
+            std::sort(order.begin() + begin, order.begin() + end, [&](std::size_t lhs, std::size_t rhs) {
+                return classifiers[lhs]->condition.at(dim).center < classifiers[rhs]->condition.at(dim).center;
+            });
+
+            std::size_t count = end - begin;
+            if (dim + 1 >= m_dimension || count <= NodeCapacity)
+            {
+                return;
+            }
+
+            double leafCount = std::ceil(static_cast<double>(count) / NodeCapacity);
+            std::size_t slabCount = static_cast<std::size_t>(std::ceil(std::pow(leafCount, 1.0 / (m_dimension - dim))));
+            std::size_t slabSize = NodeCapacity * static_cast<std::size_t>(std::ceil(leafCount / slabCount));
+
+            for (std::size_t slabBegin = begin; slabBegin < end; slabBegin += slabSize)
+            {
+                tile(order, slabBegin, std::min(slabBegin + slabSize, end), dim + 1, classifiers);
+            }
+        }
+
+        void extendBounds(std::size_t nodeIdx, const T * lower, const T * upper)
+        {
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                m_nodeLower[nodeIdx * m_dimension + d] = std::min(m_nodeLower[nodeIdx * m_dimension + d], lower[d]);
+                m_nodeUpper[nodeIdx * m_dimension + d] = std::max(m_nodeUpper[nodeIdx * m_dimension + d], upper[d]);
+            }
+        }
+
+        std::size_t addNode(std::size_t begin, std::size_t end, bool isLeaf)
+        {
+            m_nodes.push_back({ begin, end, isLeaf });
+            m_nodeLower.resize(m_nodes.size() * m_dimension, std::numeric_limits<T>::infinity());
+            m_nodeUpper.resize(m_nodes.size() * m_dimension, -std::numeric_limits<T>::infinity());
+            return m_nodes.size() - 1;
+        }
+
+        // Bulk-loads the tree from all live classifiers
+        void rebuild()
+        {
+            std::vector<ClassifierPtr> classifiers;
+            classifiers.reserve(m_positions.size());
+            for (auto && cl : m_entries)
+            {
+                if (cl)
+                {
+                    classifiers.push_back(cl);
+                }
+            }
+            classifiers.insert(classifiers.end(), m_buffer.begin(), m_buffer.end());
+
+            std::vector<std::size_t> order(classifiers.size());
+            std::iota(order.begin(), order.end(), 0);
+            tile(order, 0, order.size(), 0, classifiers);
+
+            m_entries.clear();
+            m_entryLower.clear();
+            m_entryUpper.clear();
+            m_nodes.clear();
+            m_nodeLower.clear();
+            m_nodeUpper.clear();
+            m_buffer.clear();
+            m_positions.clear();
+            m_tombstoneCount = 0;
+
+            for (auto && idx : order)
+            {
+                auto && cl = classifiers[idx];
+                m_positions[cl.get()] = m_entries.size();
+                m_entries.push_back(cl);
+                for (std::size_t d = 0; d < m_dimension; ++d)
+                {
+                    auto && symbol = cl->condition.at(d);
+                    m_entryLower.push_back(symbol.center - symbol.spread);
+                    m_entryUpper.push_back(symbol.center + symbol.spread);
+                }
+            }
+
+            if (m_entries.empty())
+            {
+                return;
+            }
+
+            // Leaves
+            std::size_t levelBegin = 0;
+            for (std::size_t begin = 0; begin < m_entries.size(); begin += NodeCapacity)
+            {
+                std::size_t end = std::min(begin + NodeCapacity, m_entries.size());
+                std::size_t nodeIdx = addNode(begin, end, true);
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    extendBounds(nodeIdx, &m_entryLower[i * m_dimension], &m_entryUpper[i * m_dimension]);
+                }
+            }
+
+            // Internal levels up to the root
+            std::size_t levelEnd = m_nodes.size();
+            while (levelEnd - levelBegin > 1)
+            {
+                for (std::size_t begin = levelBegin; begin < levelEnd; begin += NodeCapacity)
+                {
+                    std::size_t end = std::min(begin + NodeCapacity, levelEnd);
+                    std::size_t nodeIdx = addNode(begin, end, false);
+                    for (std::size_t i = begin; i < end; ++i)
+                    {
+                        extendBounds(nodeIdx, &m_nodeLower[i * m_dimension], &m_nodeUpper[i * m_dimension]);
+                    }
+                }
+                levelBegin = levelEnd;
+                levelEnd = m_nodes.size();
+            }
+        }
+
+        void rebuildIfNeeded()
+        {
+            std::size_t staleCount = m_buffer.size() + m_tombstoneCount;
+            if (staleCount > minRebuildCount && staleCount * 100 > m_entries.size() * RebuildPercentage)
+            {
+                rebuild();
+            }
+        }
+
+        bool contains(const T * lower, const T * upper, const std::vector<T> & situation) const
+        {
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                if (!(lower[d] <= situation[d] && situation[d] < upper[d]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool intersects(std::size_t nodeIdx, const std::vector<T> & situation) const
+        {
+            // Node boxes are closed on both ends so that they never prune a matching entry
+            for (std::size_t d = 0; d < m_dimension; ++d)
+            {
+                if (situation[d] < m_nodeLower[nodeIdx * m_dimension + d] || m_nodeUpper[nodeIdx * m_dimension + d] < situation[d])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <class Function>
+        void visit(std::size_t nodeIdx, const std::vector<T> & situation, Function & f) const
+        {
+            if (!intersects(nodeIdx, situation))
+            {
+                return;
+            }
+
+            const Node & node = m_nodes[nodeIdx];
+            if (node.isLeaf)
+            {
+                for (std::size_t i = node.begin; i < node.end; ++i)
+                {
+                    if (m_entries[i] && contains(&m_entryLower[i * m_dimension], &m_entryUpper[i * m_dimension], situation))
+                    {
+                        f(m_entries[i]);
+                    }
+                }
+            }
+            else
+            {
+                for (std::size_t i = node.begin; i < node.end; ++i)
+                {
+                    visit(i, situation, f);
+                }
+            }
+        }
+
+    public:
+        // Constructor
+        RTreeMatchIndex() : m_dimension(0), m_tombstoneCount(0) {}
+
+        template <class Constants>
+        explicit RTreeMatchIndex(const Constants &) : RTreeMatchIndex() {}
+
+        // Destructor
+        virtual ~RTreeMatchIndex() = default;
+
+        void insert(const ClassifierPtr & cl)
+        {
+            assert(m_positions.count(cl.get()) == 0);
+
+            if (m_positions.empty() && m_dimension != cl->condition.size())
+            {
+                clear();
+                m_dimension = cl->condition.size();
+            }
+
+            assert(m_dimension == cl->condition.size());
+
+            m_positions[cl.get()] = bufferPosition(m_buffer.size());
+            m_buffer.push_back(cl);
+
+            rebuildIfNeeded();
+        }
+
+        void erase(const ClassifierPtr & cl)
+        {
+            auto it = m_positions.find(cl.get());
+            if (it == m_positions.end())
+            {
+                return;
+            }
+
+            std::size_t position = it->second;
+            m_positions.erase(it);
+
+            if (isBufferPosition(position))
+            {
+                std::size_t bufferIdx = position - bufferPosition(0);
+                if (bufferIdx + 1 != m_buffer.size())
+                {
+                    m_buffer[bufferIdx] = m_buffer.back();
+                    m_positions[m_buffer[bufferIdx].get()] = position;
+                }
+                m_buffer.pop_back();
+            }
+            else
+            {
+                m_entries[position].reset();
+                ++m_tombstoneCount;
+            }
+
+            rebuildIfNeeded();
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_entryLower.clear();
+            m_entryUpper.clear();
+            m_tombstoneCount = 0;
+            m_nodes.clear();
+            m_nodeLower.clear();
+            m_nodeUpper.clear();
+            m_buffer.clear();
+            m_positions.clear();
+        }
+
+        // Calls f for each indexed classifier matching the situation
+        template <class Function>
+        void forEachMatchingClassifier(const std::vector<T> & situation, Function f) const
+        {
+            assert(m_positions.empty() || m_dimension == situation.size());
+
+            if (!m_nodes.empty())
+            {
+                visit(m_nodes.size() - 1, situation, f);
+            }
+
+            if (!m_buffer.empty())
+            {
+                auto && preparedSituation = Condition::prepareSituation(situation);
+                for (auto && cl : m_buffer)
+                {
+                    if (cl->condition.matches(preparedSituation))
+                    {
+                        f(cl);
+                    }
+                }
+            }
+        }
+    };
+
+}
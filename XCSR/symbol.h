@@ -4,6 +4,10 @@
 #include <sstream>
 #include <iomanip>
 #include <string>
+#include <functional>
+
+#include "../XCS/hash.h"
+#include "../XCS/binary_stream.h"
 
 namespace XCSR
 {
@@ -29,6 +33,12 @@ namespace XCSR
             return stream.str();
         }
 
+        // Returns the same value for equal symbols
+        std::size_t hash() const
+        {
+            return XCS::hashCombine(std::hash<T>()(center), std::hash<T>()(spread));
+        }
+
         friend bool operator== (const Symbol & lhs, const Symbol & rhs)
         {
             return lhs.center == rhs.center && lhs.spread == rhs.spread;
@@ -63,6 +73,18 @@ namespace XCSR
         {
             assert(false);
         }
+
+        void write(XCS::BinaryWriter & writer) const
+        {
+            writer.write(center);
+            writer.write(spread);
+        }
+
+        void read(XCS::BinaryReader & reader)
+        {
+            reader.read(center);
+            reader.read(spread);
+        }
     };
 
 }
\ No newline at end of file